@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -10,6 +11,11 @@ namespace lab3 {
 
 std::int64_t pid();
 bool is_process_alive(std::int64_t other_pid);
+// Длина "YYYY-MM-DD HH:MM:SS.mmm" без завершающего '\0'.
+constexpr std::size_t kTimestampLen = 23;
+// Пишет текущее локальное время в out (не меньше kTimestampLen + 1 байт), без аллокаций.
+// Дата и время кэшируются на текущую секунду, на каждый вызов форматируются только миллисекунды.
+std::size_t timestamp(char* out);
 std::string timestamp();
 std::string exe_path();
 
@@ -29,7 +35,14 @@ private:
 #endif
 };
 
-void log_line(const std::string& line);
+void log_line(std::string_view line);
+// Пишет в лог "<timestamp> <сообщение>": метка времени из кэша timestamp(char*)
+// и сообщение в формате printf собираются в буфере на стеке, без std::string.
+void log_event(const char* fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 1, 2)))
+#endif
+    ;
 
 struct SharedMap {
 #ifdef _WIN32
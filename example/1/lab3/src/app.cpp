@@ -16,7 +16,7 @@ namespace {
 
 void run_child(int mode, SharedMap& map) {
     const auto self = pid();
-    log_line(timestamp() + " child" + std::to_string(mode) + " start pid=" + std::to_string(self));
+    log_event("child%d start pid=%lld", mode, static_cast<long long>(self));
     {
         FileLock lock(shared_file_path() + ".lock");
         if (lock.locked() && map.ptr) {
@@ -34,7 +34,7 @@ void run_child(int mode, SharedMap& map) {
             map.ptr->counter /= 2;
         }
     }
-    log_line(timestamp() + " child" + std::to_string(mode) + " exit pid=" + std::to_string(self));
+    log_event("child%d exit pid=%lld", mode, static_cast<long long>(self));
 }
 
 }  // namespace
@@ -47,7 +47,7 @@ void run_app(bool is_child, int child_mode) {
     }
 
     const auto self = pid();
-    log_line(timestamp() + " start pid=" + std::to_string(self));
+    log_event("start pid=%lld", static_cast<long long>(self));
 
     if (is_child) {
         run_child(child_mode, map);
@@ -69,7 +69,7 @@ void run_app(bool is_child, int child_mode) {
                     FileLock lock(shared_file_path() + ".lock");
                     if (lock.locked() && map.ptr) {
                         map.ptr->counter = val;
-                        log_line(timestamp() + " pid=" + std::to_string(self) + " set counter=" + std::to_string(val));
+                        log_event("pid=%lld set counter=%lld", static_cast<long long>(self), val);
                     }
                 } else {
                     std::cout << "Usage: set <number>\n";
@@ -108,7 +108,7 @@ void run_app(bool is_child, int child_mode) {
                 } else if (should_take_over(*map.ptr, self)) {
                     map.ptr->owner_pid = self;
                     map.ptr->owner_heartbeat_ms = t;
-                    log_line(timestamp() + " pid=" + std::to_string(self) + " became owner");
+                    log_event("pid=%lld became owner", static_cast<long long>(self));
                 }
             }
         }
@@ -131,7 +131,7 @@ void run_app(bool is_child, int child_mode) {
                         cnt = map.ptr->counter;
                     }
                 }
-                log_line(timestamp() + " pid=" + std::to_string(self) + " counter=" + std::to_string(cnt));
+                log_event("pid=%lld counter=%lld", static_cast<long long>(self), static_cast<long long>(cnt));
             }
 
             if (t - last_spawn >= 3000) {
@@ -148,7 +148,7 @@ void run_app(bool is_child, int child_mode) {
                 }
 
                 if (child_running) {
-                    log_line(timestamp() + " pid=" + std::to_string(self) + " skip spawn: child still running");
+                    log_event("pid=%lld skip spawn: child still running", static_cast<long long>(self));
                 } else {
                     auto p1 = launch_child(1);
                     auto p2 = launch_child(2);
@@ -160,9 +160,10 @@ void run_app(bool is_child, int child_mode) {
                         }
                     }
                     if (!p1 || !p2) {
-                        log_line(timestamp() + " pid=" + std::to_string(self) + " failed to spawn child(s)");
+                        log_event("pid=%lld failed to spawn child(s)", static_cast<long long>(self));
                     } else {
-                        log_line(timestamp() + " pid=" + std::to_string(self) + " spawned children " + std::to_string(p1) + ", " + std::to_string(p2));
+                        log_event("pid=%lld spawned children %lld, %lld", static_cast<long long>(self),
+                                  static_cast<long long>(p1), static_cast<long long>(p2));
                     }
                 }
             }
@@ -173,7 +174,7 @@ void run_app(bool is_child, int child_mode) {
     if (input_thread.joinable()) input_thread.join();
     if (counter_thread.joinable()) counter_thread.join();
 
-    log_line(timestamp() + " exit pid=" + std::to_string(self));
+    log_event("exit pid=%lld", static_cast<long long>(self));
     unmap_shared(map);
 }
 
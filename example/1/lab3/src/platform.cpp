@@ -1,7 +1,10 @@
 ﻿#include "platform.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
@@ -66,24 +69,43 @@ namespace lab3
 #endif
     }
 
-    std::string timestamp()
+    std::size_t timestamp(char *out)
     {
         using namespace std::chrono;
-        auto now = system_clock::now();
-        auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
-        std::time_t t = system_clock::to_time_t(now);
-        std::tm tm{};
+        constexpr std::size_t prefix_len = 19; // "YYYY-MM-DD HH:MM:SS"
+        thread_local long long cached_sec = -1;
+        thread_local char cached_prefix[prefix_len + 1] = {};
+
+        const long long epoch_ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+        const long long sec = epoch_ms / 1000;
+        const long long ms = epoch_ms % 1000;
+        if (sec != cached_sec)
+        {
+            std::time_t t = static_cast<std::time_t>(sec);
+            std::tm tm{};
 #ifdef _WIN32
-        localtime_s(&tm, &t);
+            localtime_s(&tm, &t);
 #else
-        localtime_r(&t, &tm);
+            localtime_r(&t, &tm);
 #endif
-        char buf[64];
-        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d.%03lld",
-                      tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-                      tm.tm_hour, tm.tm_min, tm.tm_sec,
-                      static_cast<long long>(ms.count()));
-        return buf;
+            std::snprintf(cached_prefix, sizeof(cached_prefix), "%04d-%02d-%02d %02d:%02d:%02d",
+                          tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                          tm.tm_hour, tm.tm_min, tm.tm_sec);
+            cached_sec = sec;
+        }
+        std::memcpy(out, cached_prefix, prefix_len);
+        out[prefix_len] = '.';
+        out[prefix_len + 1] = static_cast<char>('0' + ms / 100);
+        out[prefix_len + 2] = static_cast<char>('0' + ms / 10 % 10);
+        out[prefix_len + 3] = static_cast<char>('0' + ms % 10);
+        out[kTimestampLen] = '\0';
+        return kTimestampLen;
+    }
+
+    std::string timestamp()
+    {
+        char buf[kTimestampLen + 1];
+        return std::string(buf, timestamp(buf));
     }
 
     std::string exe_path()
@@ -196,7 +218,7 @@ namespace lab3
 #endif
     }
 
-    void log_line(const std::string &line)
+    void log_line(std::string_view line)
     {
         const auto path = log_file_path();
         ensure_parent_exists(path);
@@ -205,6 +227,22 @@ namespace lab3
         out << line << "\n";
     }
 
+    void log_event(const char *fmt, ...)
+    {
+        char buf[512];
+        std::size_t len = timestamp(buf);
+        buf[len++] = ' ';
+
+        va_list args;
+        va_start(args, fmt);
+        const int n = std::vsnprintf(buf + len, sizeof(buf) - len, fmt, args);
+        va_end(args);
+        if (n > 0)
+            len += std::min(static_cast<std::size_t>(n), sizeof(buf) - len - 1);
+
+        log_line(std::string_view(buf, len));
+    }
+
     bool map_shared(SharedMap &m)
     {
         const auto path = shared_file_path();
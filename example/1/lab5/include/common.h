@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -14,6 +15,13 @@ inline std::int64_t now_ms() {
     return duration_cast<milliseconds>(Clock::now().time_since_epoch()).count();
 }
 
+// Length of "YYYY-MM-DD HH:MM:SS.mmm" (without the terminating '\0').
+constexpr std::size_t kIsoTimeLen = 23;
+
+// Writes the local time of tp into out (at least kIsoTimeLen + 1 bytes) and
+// returns the length. The date/time part is cached per thread for the current
+// second, so the hot path only patches in milliseconds and never allocates.
+std::size_t format_iso_time(const TimePoint& tp, char* out);
 std::string iso_time(const TimePoint& tp);
 
 std::string data_dir();
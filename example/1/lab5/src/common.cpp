@@ -2,9 +2,9 @@
 
 #include <filesystem>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
 #include <ctime>
+#include <limits>
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -32,19 +32,42 @@ std::string exe_path() {
 }
 }
 
-std::string iso_time(const TimePoint& tp) {
+std::size_t format_iso_time(const TimePoint& tp, char* out) {
     using namespace std::chrono;
-    auto tt = Clock::to_time_t(tp);
-    std::tm tm{};
+    constexpr std::size_t prefix_len = 19;  // "YYYY-MM-DD HH:MM:SS"
+    thread_local std::int64_t cached_sec = std::numeric_limits<std::int64_t>::min();
+    thread_local char cached_prefix[prefix_len + 1] = {};
+
+    const auto epoch_ms = duration_cast<milliseconds>(tp.time_since_epoch()).count();
+    std::int64_t sec = epoch_ms / 1000;
+    std::int64_t ms = epoch_ms % 1000;
+    if (ms < 0) {
+        ms += 1000;
+        --sec;
+    }
+    if (sec != cached_sec) {
+        auto tt = static_cast<std::time_t>(sec);
+        std::tm tm{};
 #ifdef _WIN32
-    localtime_s(&tm, &tt);
+        localtime_s(&tm, &tt);
 #else
-    localtime_r(&tt, &tm);
+        localtime_r(&tt, &tm);
 #endif
-    auto ms = duration_cast<milliseconds>(tp.time_since_epoch()) % 1000;
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(3) << std::setfill('0') << ms.count();
-    return oss.str();
+        std::strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_sec = sec;
+    }
+    std::memcpy(out, cached_prefix, prefix_len);
+    out[prefix_len] = '.';
+    out[prefix_len + 1] = static_cast<char>('0' + ms / 100);
+    out[prefix_len + 2] = static_cast<char>('0' + ms / 10 % 10);
+    out[prefix_len + 3] = static_cast<char>('0' + ms % 10);
+    out[kIsoTimeLen] = '\0';
+    return kIsoTimeLen;
+}
+
+std::string iso_time(const TimePoint& tp) {
+    char buf[kIsoTimeLen + 1];
+    return std::string(buf, format_iso_time(tp, buf));
 }
 
 static std::string cached_dir;
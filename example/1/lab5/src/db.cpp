@@ -38,26 +38,32 @@ bool Database::open(const std::string& path, std::string& err) {
 }
 
 bool Database::insert_measurement(const Sample& s, std::string& err) {
+    char iso[kIsoTimeLen + 1];
+    format_iso_time(s.ts, iso);
     std::ostringstream oss;
     oss << "INSERT INTO measurements(epoch_ms, iso, value) VALUES("
         << std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count()
-        << ",'" << iso_time(s.ts) << "'," << s.value << ");";
+        << ",'" << iso << "'," << s.value << ");";
     return exec(oss.str(), err);
 }
 
 bool Database::insert_hourly(const Sample& s, std::string& err) {
+    char iso[kIsoTimeLen + 1];
+    format_iso_time(s.ts, iso);
     std::ostringstream oss;
     oss << "INSERT INTO hourly_avg(epoch_ms, iso, value) VALUES("
         << std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count()
-        << ",'" << iso_time(s.ts) << "'," << s.value << ");";
+        << ",'" << iso << "'," << s.value << ");";
     return exec(oss.str(), err);
 }
 
 bool Database::insert_daily(const Sample& s, std::string& err) {
+    char iso[kIsoTimeLen + 1];
+    format_iso_time(s.ts, iso);
     std::ostringstream oss;
     oss << "INSERT INTO daily_avg(epoch_ms, iso, value) VALUES("
         << std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count()
-        << ",'" << iso_time(s.ts) << "'," << s.value << ");";
+        << ",'" << iso << "'," << s.value << ");";
     return exec(oss.str(), err);
 }
 
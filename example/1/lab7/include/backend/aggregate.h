@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lab5 {
+
+// Aggregate functions for /api/aggregate?fn=..., combined as a bit mask.
+enum AggFn : unsigned {
+    kAggAvg = 1u << 0,
+    kAggMin = 1u << 1,
+    kAggMax = 1u << 2,
+    kAggSum = 1u << 3,
+    kAggCount = 1u << 4,
+};
+
+struct AggBucket {
+    std::int64_t start_ms = 0;
+    std::size_t count = 0;
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// "500ms", "30s", "5m", "1h", "1d" or plain milliseconds; nullopt if malformed or overflowing.
+std::optional<std::int64_t> parse_step(const std::string& text);
+// "avg,min,max" -> function list in request order; empty on unknown names.
+std::vector<AggFn> parse_agg_fns(const std::string& text);
+const char* agg_fn_name(AggFn fn);
+
+// Buckets sorted column arrays in a single pass. Hour and day steps that tile a day
+// use local-time bucket_start() boundaries, matching hourly_avg/daily_avg; other
+// steps use [k*step_ms, (k+1)*step_ms) from the epoch. Each bucket is a contiguous
+// run of ts, reduced with SIMD sum/min/max kernels.
+void aggregate_columns(const std::int64_t* ts, const double* values, std::size_t n, std::int64_t step_ms,
+                       std::vector<AggBucket>& out);
+
+}  // namespace lab5
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "sample.h"
+
+namespace lab5 {
+
+// Parses "epoch_ms value" or "value" (stamped with the time it is read) lines
+// for the default sensor. Returns false for anything else.
+bool parse_bulk_line(const char* begin, const char* end, std::int64_t now, std::int64_t& epoch_ms, double& value);
+
+// Reads a stream in large blocks for bulk loading. Lines are located with
+// memchr, which libc implements with SIMD, and parsed in place with from_chars,
+// so no per-line string or stream is created.
+class BulkReader {
+public:
+    explicit BulkReader(std::FILE* in, std::size_t block_size = 1 << 20);
+
+    // Up to max parsed samples; 0 once the input is exhausted.
+    std::size_t next_batch(Sample* out, std::size_t max);
+
+    std::uint64_t lines() const { return lines_; }
+    std::uint64_t skipped() const { return skipped_; }
+
+private:
+    bool refill();
+
+    std::FILE* in_;
+    std::vector<char> buf_;
+    std::size_t begin_ = 0;  // first unparsed byte
+    std::size_t end_ = 0;    // end of valid data
+    bool eof_ = false;
+    std::uint64_t lines_ = 0;
+    std::uint64_t skipped_ = 0;
+};
+
+}  // namespace lab5
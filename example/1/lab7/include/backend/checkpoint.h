@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "rollup.h"
+#include "sample.h"
+#include "window_stats.h"
+
+namespace lab5 {
+
+// Copy of one sensor's aggregation state taken for the checkpoint.
+struct SensorAggregates {
+    SensorId sensor = kDefaultSensor;
+    std::int64_t applied_ms = 0;  // newest sample folded into rollups and windows
+    RollupCascade rollups;
+    WindowSet windows;
+};
+
+// Aggregation state (open rollup buckets and sliding windows of every sensor) saved
+// next to the DB, so a restart resumes partial buckets instead of losing them. Raw
+// rows newer than applied_ms (reorder buffers, samples after the last checkpoint)
+// are not saved: they are already in the DB and get replayed on restart. The file
+// size depends on the number of sensors and window contents, not on the amount of
+// stored data; it is synced to disk and replaced atomically.
+bool save_checkpoint(const std::string& path, std::int64_t saved_ms, const std::vector<SensorAggregates>& sensors,
+                     std::string& err);
+
+using RestoreSensor = std::function<void(SensorAggregates&&)>;
+
+// Parses the whole file, then calls restore once per sensor. windows supplies the
+// configured window set that saved windows are loaded into. Returns false without
+// calling restore if the file is missing, invalid or written in another format version.
+bool load_checkpoint(const std::string& path, const WindowSet& windows, const RestoreSensor& restore, std::string& err);
+
+}  // namespace lab5
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -14,10 +15,21 @@ inline std::int64_t now_ms() {
     return duration_cast<milliseconds>(Clock::now().time_since_epoch()).count();
 }
 
+// Length of "YYYY-MM-DD HH:MM:SS.mmm" (without the terminating '\0').
+constexpr std::size_t kIsoTimeLen = 23;
+
+// Writes the local time of tp into out (at least kIsoTimeLen + 1 bytes) and
+// returns the length. The date/time part is cached per thread for the current
+// second, so the hot path only patches in milliseconds and never allocates.
+std::size_t format_iso_time(const TimePoint& tp, char* out);
 std::string iso_time(const TimePoint& tp);
 
+// text with quotes, backslashes and control characters escaped for a JSON string literal.
+std::string json_escape(const std::string& text);
+
 std::string data_dir();
 std::string db_path();
+std::string checkpoint_path();
 std::string web_root();
 
 }  // namespace lab5
@@ -1,36 +1,66 @@
 ﻿#pragma once
 
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common.h"
+#include "rollup.h"
 #include "sample.h"
 
 struct sqlite3;
 
 namespace lab5 {
 
+// Every table is keyed by (sensor_id, epoch_ms); databases created before sensors
+// existed are migrated on open with their rows assigned to kDefaultSensor.
 class Database {
 public:
     Database();
     ~Database();
     bool open(const std::string& path, std::string& err);
 
+    bool load_sensors(std::vector<std::pair<SensorId, std::string>>& out, std::string& err);
+    bool insert_sensor(SensorId id, const std::string& name, std::string& err);
+
     bool insert_measurement(const Sample& s, std::string& err);
-    bool insert_hourly(const Sample& s, std::string& err);
-    bool insert_daily(const Sample& s, std::string& err);
+    // Inserts n raw rows in one transaction. Samples sharing a millisecond are all kept,
+    // so raw rows agree with the rollups, which count every sample.
+    bool insert_measurements(const Sample* samples, std::size_t n, std::string& err);
+    // Upserts the bucket starting at s.ts into a rollup table (see rollup.h).
+    bool insert_rollup(const std::string& table, const Sample& s, std::string& err);
+    // Upserts bucket averages in a single transaction with one prepared statement per level.
+    bool insert_rollups(const std::vector<RollupRow>& rows, std::string& err);
 
-    std::optional<Sample> latest_measurement(std::string& err);
-    bool query_range(const std::string& table, std::int64_t start_ms, std::int64_t end_ms, std::vector<Sample>& out, std::string& err);
+    std::optional<Sample> latest_measurement(SensorId sensor, std::string& err);
+    // limit > 0 returns only the first limit rows of the range.
+    bool query_range(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms, std::vector<Sample>& out,
+                     std::string& err, std::size_t limit = 0);
+    // Same rows as query_range, returned as separate timestamp/value columns.
+    bool query_columns(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms,
+                       std::vector<std::int64_t>& ts, std::vector<double>& values, std::string& err);
+    // Oldest and newest epoch_ms in a table over all sensors; false with empty err if the table is empty.
+    bool time_bounds(const std::string& table, std::int64_t& first_ms, std::int64_t& last_ms, std::string& err);
+    // Count and sum of the values with start_ms <= epoch_ms < end_ms.
+    bool sum_range(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms, Accum& acc,
+                   std::string& err);
+    std::size_t count_range(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms, std::string& err);
 
     bool prune_measurements(std::int64_t cutoff_ms, std::string& err);
-    bool prune_hourly(std::int64_t cutoff_ms, std::string& err);
-    bool prune_daily_current_year(std::string& err);
+    bool prune_rollup(const std::string& table, std::int64_t cutoff_ms, std::string& err);
+    // Deletes daily rows outside the local calendar year of now_ms.
+    bool prune_daily_current_year(std::int64_t now_ms, std::string& err);
 
 private:
     bool exec(const std::string& sql, std::string& err);
+    bool table_columns(const std::string& table, std::vector<std::string>& columns, std::string& err);
+    // Creates a (sensor_id, epoch_ms) series table, migrating a pre-sensor one in place.
+    // unique_time makes the pair the primary key (one rollup row per bucket); otherwise
+    // it is a plain index and rows may share a millisecond (raw measurements).
+    bool create_series_table(const std::string& table, bool unique_time, std::string& err);
 
     sqlite3* db_ = nullptr;
 };
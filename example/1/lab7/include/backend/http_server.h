@@ -6,16 +6,22 @@
 
 namespace lab5 {
 
+struct HttpResponse {
+    std::string body;
+    std::string content_type = "application/json";
+    std::string status = "200 OK";
+};
+
 class HttpServer {
 public:
-    // handler returns {body, content_type}
-    bool start(int port, std::function<std::pair<std::string, std::string>(const std::string&)> handler, std::string& err);
+    // A handler that throws is answered with 500 instead of taking the server down.
+    bool start(int port, std::function<HttpResponse(const std::string&)> handler, std::string& err);
     void stop();
 
 private:
     void run(int port);
 
-    std::function<std::pair<std::string, std::string>(const std::string&)> handler_;
+    std::function<HttpResponse(const std::string&)> handler_;
     bool running_ = false;
     std::thread thread_;
 #ifdef _WIN32
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "checkpoint.h"
+#include "db.h"
+#include "reorder.h"
+#include "rollup.h"
+#include "sample.h"
+#include "sensor_map.h"
+#include "spsc_ring.h"
+#include "window_stats.h"
+
+namespace lab5 {
+
+struct IngestConfig {
+    std::vector<std::string> windows;  // sliding windows kept per sensor (see WindowSet)
+    std::int64_t reorder_delay_ms = 0;
+    std::size_t queue_capacity = 1 << 14;
+    bool store = true;  // false: aggregate in memory only, no DB writes (benchmarks)
+};
+
+// What /api/current serves for one sensor.
+struct CurrentView {
+    std::optional<Sample> latest;
+    std::vector<WindowSnapshot> windows;
+};
+
+// Shard that owns a subset of sensors (see shard_for): their rollups, windows
+// and reorder buffers, plus its own DB connection. Samples come in through an
+// SPSC ring filled by a single router thread and are processed in batches, with
+// raw rows and closed buckets written in one transaction each per batch.
+class IngestShard {
+public:
+    IngestShard(std::size_t index, IngestConfig config);
+    ~IngestShard();
+
+    bool open(const std::string& db_path, std::string& err);
+    // Before start(): state loaded from a checkpoint.
+    void restore(SensorAggregates&& state);
+    // Before start(): re-aggregates raw rows of a sensor that are already stored but
+    // newer than its restored state (see checkpoint.h); they are not written again.
+    void replay(SensorId sensor, const std::vector<Sample>& rows);
+    // cpu >= 0 pins the worker thread to that core where supported.
+    void start(int cpu);
+    // Router thread only; waits while the ring is full.
+    void push(const Sample& s);
+    void push_batch(const Sample* samples, std::size_t n);
+    // Processes everything queued, releases reorder buffers and rewrites dirty buckets.
+    void stop();
+    // After stop(): writes partially filled buckets (shutdown).
+    void flush_open();
+
+    // Appends a copy of every sensor's state, taken between batches; the worker
+    // is paused only for the copy.
+    void snapshot(std::vector<SensorAggregates>& out);
+
+    std::optional<CurrentView> current(SensorId sensor) const;
+    std::uint64_t processed() const { return processed_.load(std::memory_order_relaxed); }
+
+private:
+    struct SensorState {
+        RollupCascade rollups;
+        WindowSet windows;
+        ReorderBuffer reorder;
+        std::int64_t last_ordered_ms = 0;
+    };
+
+    void run();
+    void process_batch(const Sample* batch, std::size_t n);
+    void aggregate(SensorState& st, const Sample& s, CurrentView& view);
+    void write_closed();
+    void flush_dirty();
+    SensorState& state_of(SensorId sensor);
+    CurrentView& view_of(SensorId sensor);
+
+    std::size_t index_;
+    IngestConfig config_;
+    Database db_;
+    std::string err_;
+    SpscRing<Sample> queue_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex state_mu_;
+    SensorMap<SensorState> states_;
+    std::vector<RollupRow> closed_;
+    std::vector<Sample> ordered_;
+    // Rollup rows that missed late samples: (sensor, level, bucket start).
+    std::set<std::tuple<SensorId, std::size_t, std::int64_t>> dirty_;
+    std::int64_t last_dirty_flush_ms_ = 0;
+    std::int64_t data_now_ms_ = 0;  // newest sample timestamp; retention is relative to it
+
+    mutable std::mutex current_mu_;
+    SensorMap<CurrentView> current_;
+    std::atomic<std::uint64_t> processed_{0};
+};
+
+// Shard owning a sensor; stable for a given shard count.
+std::size_t shard_for(SensorId sensor, std::size_t shards);
+
+}  // namespace lab5
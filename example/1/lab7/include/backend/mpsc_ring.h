@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "wait_word.h"
+
+namespace lab5 {
+
+// What a producer does when the ring is full.
+enum class Overflow {
+    kBlock,       // wait for the consumer
+    kDropNewest,  // discard the sample being pushed
+    kDropOldest,  // discard the oldest queued sample to make room
+};
+
+struct RingStats {
+    std::uint64_t pushed = 0;
+    std::uint64_t popped = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t cas_retries = 0;     // lost races on head/tail
+    std::uint64_t producer_waits = 0;  // producer slept on a full ring
+    std::uint64_t consumer_waits = 0;  // consumer slept on an empty ring
+    std::uint64_t wakeups = 0;         // notifications that had to wake a sleeper
+};
+
+// Bounded multi-producer queue drained in batches by one consumer. Slots carry
+// sequence numbers (D. Vyukov's bounded queue), so producers only contend on one
+// CAS of the tail per batch; the consumer claims a whole batch with one CAS of the head.
+// Waiting spins briefly and then sleeps on a WaitWord (futex on Linux); a push
+// only makes a syscall when the consumer is actually asleep.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(std::size_t capacity, Overflow overflow = Overflow::kBlock) : overflow_(overflow) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        slots_ = std::make_unique<Slot[]>(cap);
+        for (std::size_t i = 0; i < cap; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+        mask_ = cap - 1;
+    }
+
+    // False if the sample was dropped or the ring is closed.
+    bool push(const T& v) { return push_batch(&v, 1) == 1; }
+
+    // Queues n samples, claiming each run of free slots with one CAS. Returns
+    // how many were queued: fewer than n if some were dropped or the ring closed.
+    std::size_t push_batch(const T* v, std::size_t n) {
+        std::size_t done = 0;
+        for (unsigned spins = 0; done < n; ++spins) {
+            if (closed_.load(std::memory_order_relaxed)) break;
+            if (const std::size_t k = try_push(v + done, n - done)) {
+                done += k;
+                spins = 0;
+                pushed_.fetch_add(k, std::memory_order_relaxed);
+                if (not_empty_.notify()) wakeups_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            switch (overflow_) {
+            case Overflow::kDropNewest:
+                dropped_.fetch_add(n - done, std::memory_order_relaxed);
+                return done;
+            case Overflow::kDropOldest: {
+                T discarded;
+                if (claim(&discarded, 1) != 0) dropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            case Overflow::kBlock: {
+                if (spins < kSpins) {
+                    std::this_thread::yield();
+                    break;
+                }
+                const std::uint32_t ticket = not_full_.prepare_wait();
+                if (!full() || closed_.load()) {
+                    not_full_.cancel_wait();
+                    break;
+                }
+                producer_waits_.fetch_add(1, std::memory_order_relaxed);
+                not_full_.wait(ticket);
+                break;
+            }
+            }
+        }
+        return done;
+    }
+
+    // Moves up to max samples into out, waiting while the ring is empty.
+    // Returns 0 only once the ring is closed and drained.
+    std::size_t pop_batch(T* out, std::size_t max) {
+        for (unsigned spins = 0;; ++spins) {
+            const std::size_t n = claim(out, max);
+            if (n != 0) {
+                popped_.fetch_add(n, std::memory_order_relaxed);
+                if (overflow_ == Overflow::kBlock && not_full_.notify()) wakeups_.fetch_add(1, std::memory_order_relaxed);
+                return n;
+            }
+            if (closed_.load()) {
+                if (empty()) return 0;
+                continue;
+            }
+            if (spins < kSpins) {
+                std::this_thread::yield();
+                continue;
+            }
+            const std::uint32_t ticket = not_empty_.prepare_wait();
+            if (!empty() || closed_.load()) {
+                not_empty_.cancel_wait();
+                continue;
+            }
+            consumer_waits_.fetch_add(1, std::memory_order_relaxed);
+            not_empty_.wait(ticket);
+        }
+    }
+
+    // Wakes everyone; pushes fail and pop_batch returns 0 once the ring is empty.
+    void close() {
+        closed_.store(true);
+        not_empty_.notify();
+        not_full_.notify();
+    }
+
+    RingStats stats() const {
+        RingStats s;
+        s.pushed = pushed_.load(std::memory_order_relaxed);
+        s.popped = popped_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.cas_retries = cas_retries_.load(std::memory_order_relaxed);
+        s.producer_waits = producer_waits_.load(std::memory_order_relaxed);
+        s.consumer_waits = consumer_waits_.load(std::memory_order_relaxed);
+        s.wakeups = wakeups_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static constexpr unsigned kSpins = 64;
+
+    struct alignas(64) Slot {
+        std::atomic<std::size_t> seq{0};
+        T value{};
+    };
+
+    // Claims up to n free slots at the tail and fills them; 0 when full.
+    std::size_t try_push(const T* v, std::size_t n) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            const std::size_t seq = slots_[pos & mask_].seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff < 0) return 0;  // full
+            if (diff > 0) {
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            std::size_t k = 1;
+            while (k < n && slots_[(pos + k) & mask_].seq.load(std::memory_order_acquire) == pos + k) ++k;
+            if (tail_.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                for (std::size_t i = 0; i < k; ++i) {
+                    Slot& slot = slots_[(pos + i) & mask_];
+                    slot.value = v[i];
+                    slot.seq.store(pos + i + 1, std::memory_order_release);
+                }
+                return k;
+            }
+            cas_retries_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Takes up to max published slots from the head. Used by the consumer and,
+    // for kDropOldest, by producers evicting the oldest sample.
+    std::size_t claim(T* out, std::size_t max) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            std::size_t n = 0;
+            while (n < max && slots_[(pos + n) & mask_].seq.load(std::memory_order_acquire) == pos + n + 1) ++n;
+            if (n == 0) return 0;
+            if (head_.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    Slot& slot = slots_[(pos + i) & mask_];
+                    out[i] = slot.value;
+                    slot.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+                }
+                return n;
+            }
+            cas_retries_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool empty() const {
+        const std::size_t pos = head_.load();
+        return slots_[pos & mask_].seq.load(std::memory_order_acquire) != pos + 1;
+    }
+    bool full() const {
+        const std::size_t pos = tail_.load();
+        return slots_[pos & mask_].seq.load(std::memory_order_acquire) != pos;
+    }
+
+    const Overflow overflow_;
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<bool> closed_{false};
+    WaitWord not_empty_;
+    WaitWord not_full_;
+
+    std::atomic<std::uint64_t> pushed_{0};
+    std::atomic<std::uint64_t> popped_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> cas_retries_{0};
+    std::atomic<std::uint64_t> producer_waits_{0};
+    std::atomic<std::uint64_t> consumer_waits_{0};
+    std::atomic<std::uint64_t> wakeups_{0};
+};
+
+}  // namespace lab5
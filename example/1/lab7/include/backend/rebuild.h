@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace lab5 {
+
+struct RebuildStats {
+    std::size_t partitions = 0;
+    std::size_t raw_rows = 0;
+    std::size_t rollup_rows = 0;
+    std::size_t skipped_rows = 0;  // buckets with pruned raw input or past their retention
+    double seconds = 0.0;
+};
+
+// Recomputes every rollup table of every registered sensor from the raw measurements
+// in db_path. The raw range is split into local-day partitions (no rollup bucket
+// crosses a day boundary), which are aggregated on `threads` workers with their own
+// connections; results are written by the calling thread in bounded transactions,
+// so a running ingest only waits for one batch at a time. threads == 0 -> hardware
+// concurrency.
+bool rebuild_rollups(const std::string& db_path, unsigned threads, RebuildStats& stats, std::string& err);
+
+}  // namespace lab5
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sample.h"
+
+namespace lab5 {
+
+// Holds incoming samples until event time has advanced delay_ms past them, then
+// releases them in timestamp order. Samples that arrive later than that are
+// released immediately and handled as late data by the caller.
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(std::int64_t delay_ms = 0, std::size_t max_size = 100000) : delay_ms_(delay_ms), max_size_(max_size) {}
+
+    // Appends samples that are ready, oldest first.
+    void push(const Sample& s, std::vector<Sample>& ready);
+    // Releases everything (shutdown).
+    void drain(std::vector<Sample>& ready);
+
+    std::int64_t delay_ms() const { return delay_ms_; }
+    std::size_t size() const { return heap_.size(); }
+
+private:
+    void pop_oldest(std::vector<Sample>& ready);
+
+    std::int64_t delay_ms_;
+    std::size_t max_size_;
+    bool seen_ = false;
+    std::int64_t max_seen_ms_ = 0;
+    std::vector<Sample> heap_;  // min-heap by timestamp
+};
+
+}  // namespace lab5
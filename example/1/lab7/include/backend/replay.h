@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "sample.h"
+
+namespace lab5 {
+
+struct ReplayFile {
+    std::string path;
+    std::string sensor;  // empty -> the default sensor
+};
+
+struct ReplayConfig {
+    std::vector<ReplayFile> files;
+    double speed = 1.0;  // 1 -> real time, N -> N times faster, 0 -> as fast as ingest takes it
+};
+
+// Parses one log line, either lab4's "epoch_ms;YYYY-MM-DD HH:MM:SS.mmm;value"
+// or 4lab's "epoch_seconds value". The line excludes the '\n'; a trailing '\r'
+// is allowed.
+bool parse_log_line(const char* begin, const char* end, std::int64_t& epoch_ms, double& value);
+
+// Read-only view of a whole file: mmap on POSIX, a heap copy elsewhere.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path, std::string& err);
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> copy_;
+};
+
+// Streams recorded logs as samples with their original timestamps. Several
+// files are merged by time; playback is paced against the first sample.
+class LogReplay {
+public:
+    // sensors[i] is the sensor of files[i].
+    bool open(const ReplayConfig& config, const std::vector<SensorId>& sensors, std::string& err);
+
+    // Up to max samples that are due. Returns 0 when nothing is due within a
+    // short wait (so the caller can check for shutdown) or when finished().
+    std::size_t next_batch(Sample* out, std::size_t max);
+    bool finished() const;
+
+    std::uint64_t lines() const { return lines_; }
+    std::uint64_t skipped() const { return skipped_; }
+
+private:
+    struct Cursor {
+        MappedFile file;
+        const char* pos = nullptr;
+        const char* end = nullptr;
+        SensorId sensor = kDefaultSensor;
+        bool has_next = false;
+        Sample next;
+    };
+
+    void advance(Cursor& c);
+    Cursor* earliest();
+
+    std::vector<std::unique_ptr<Cursor>> cursors_;
+    double speed_ = 1.0;
+    bool started_ = false;
+    std::chrono::steady_clock::time_point wall_origin_;
+    std::int64_t data_origin_ms_ = 0;
+    std::uint64_t lines_ = 0;
+    std::uint64_t skipped_ = 0;
+};
+
+}  // namespace lab5
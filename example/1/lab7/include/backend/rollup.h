@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "sample.h"
+
+namespace lab5 {
+
+constexpr std::int64_t kDayMs = 24LL * 60 * 60 * 1000;
+constexpr std::int64_t kRawRetentionMs = kDayMs;
+
+// One resolution of the rollup cascade, stored in its own table.
+struct RollupLevel {
+    const char* name;           // value accepted by /api/stats?bucket=
+    const char* table;
+    std::int64_t period_ms;     // bucket width; kDayMs means a local calendar day
+    std::int64_t retention_ms;  // 0 -> keep the current year only
+};
+
+constexpr std::size_t kRollupLevelCount = 5;
+extern const std::array<RollupLevel, kRollupLevelCount> kRollupLevels;
+
+// Level by API name ("1m", "5m", ..., also "hourly"/"daily"); nullptr if unknown.
+const RollupLevel* find_rollup_level(const std::string& name);
+
+// Local-time bucket containing epoch_ms and the start of the following one.
+std::int64_t bucket_start(std::int64_t epoch_ms, std::int64_t period_ms);
+std::int64_t bucket_end(std::int64_t start_ms, std::int64_t period_ms);
+
+// Part of a stats range served from a single tier (level == nullptr -> raw measurements).
+struct TierSegment {
+    const RollupLevel* level = nullptr;
+    std::int64_t start_ms = 0;
+    std::int64_t end_ms = 0;
+};
+
+// Picks the finest tier whose point count over [start_ms, end_ms] fits max_points.
+// Parts of the range older than that tier's retention are stitched from the next
+// tiers that still hold them. count_raw(start, end) returns the number of raw rows.
+// Segments are returned oldest first.
+std::vector<TierSegment> plan_tiers(std::int64_t start_ms, std::int64_t end_ms, std::size_t max_points, std::int64_t now_ms,
+                                    const std::function<std::size_t(std::int64_t, std::int64_t)>& count_raw);
+
+// Closed (or flushed) bucket of a given level.
+struct RollupRow {
+    std::size_t level = 0;
+    SensorId sensor = kDefaultSensor;
+    std::int64_t start_ms = 0;
+    Accum acc;
+};
+
+// Maintains every rollup level in one pass: samples go into the finest level,
+// and each closed bucket is folded into the next coarser one. Per-sample cost is
+// a comparison against the open bucket end; time conversions happen only when a
+// bucket closes.
+class RollupCascade {
+public:
+    explicit RollupCascade(SensorId sensor = kDefaultSensor) : sensor_(sensor) {}
+
+    // A sample older than the open 1m bucket is merged into the finest level whose
+    // open bucket still covers it. Finer levels whose most recently closed bucket
+    // covers it are corrected in place and re-emitted into closed. Returns a bit
+    // mask of the remaining levels (bit n = kRollupLevels[n]) whose bucket already
+    // closed without the sample (0 for in-order samples); the caller recomputes
+    // those rows from raw data.
+    std::uint32_t add(std::int64_t epoch_ms, double value, std::vector<RollupRow>& closed);
+    // Emits all partially filled buckets (e.g. on shutdown) and resets the cascade.
+    void flush(std::vector<RollupRow>& closed);
+
+    // Open buckets of every level, for warm restart (see checkpoint.h).
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+private:
+    struct OpenBucket {
+        std::int64_t start_ms = 0;
+        std::int64_t end_ms = 0;
+        Accum acc;
+    };
+
+    void feed(std::size_t level, std::int64_t epoch_ms, const Accum& acc, std::vector<RollupRow>& closed);
+
+    SensorId sensor_;
+    std::array<OpenBucket, kRollupLevelCount> open_{};
+    // Last bucket each level emitted, kept for late samples; not checkpointed.
+    std::array<OpenBucket, kRollupLevelCount> last_closed_{};
+};
+
+}  // namespace lab5
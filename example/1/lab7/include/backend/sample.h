@@ -1,20 +1,27 @@
 ﻿#pragma once
 
 #include <cstddef>
+#include <cstdint>
 
 #include "common.h"
 
 namespace lab5 {
 
+// Compact sensor id from the sensors table (see sensors.h).
+using SensorId = std::uint32_t;
+constexpr SensorId kDefaultSensor = 0;
+
 struct Sample {
     TimePoint ts;
     double value = 0.0;
+    SensorId sensor = kDefaultSensor;
 };
 
 struct Accum {
     double sum = 0.0;
     std::size_t count = 0;
     void add(double v) { sum += v; ++count; }
+    void merge(const Accum& o) { sum += o.sum; count += o.count; }
     double avg() const { return count ? sum / count : 0.0; }
     void reset() { sum = 0.0; count = 0; }
 };
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "sample.h"
+
+namespace lab5 {
+
+// Hash map from SensorId to per-sensor state in one flat array with linear
+// probing. The table is kept at most half full, so a lookup touches one or two
+// adjacent slots whatever the number of sensors. No erase: sensors are never
+// forgotten while the process runs.
+template <typename T>
+class SensorMap {
+public:
+    T* find(SensorId id) {
+        if (slots_.empty()) return nullptr;
+        for (std::size_t i = slot_of(id);; i = (i + 1) & (slots_.size() - 1)) {
+            auto& slot = slots_[i];
+            if (!slot.value) return nullptr;
+            if (slot.key == id) return &*slot.value;
+        }
+    }
+    const T* find(SensorId id) const { return const_cast<SensorMap*>(this)->find(id); }
+
+    // Inserts or replaces the value of id.
+    T& insert(SensorId id, T value) {
+        if ((size_ + 1) * 2 > slots_.size()) grow();
+        return place(id, std::move(value));
+    }
+
+    std::size_t size() const { return size_; }
+
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& slot : slots_) {
+            if (slot.value) f(slot.key, *slot.value);
+        }
+    }
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const auto& slot : slots_) {
+            if (slot.value) f(slot.key, *slot.value);
+        }
+    }
+
+private:
+    struct Slot {
+        SensorId key = 0;
+        std::optional<T> value;
+    };
+
+    // Fibonacci hashing: the top bits of id * 2^64/phi spread consecutive ids.
+    std::size_t slot_of(SensorId id) const {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(id) * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    T& place(SensorId id, T&& value) {
+        for (std::size_t i = slot_of(id);; i = (i + 1) & (slots_.size() - 1)) {
+            auto& slot = slots_[i];
+            if (!slot.value) {
+                slot.key = id;
+                ++size_;
+                return slot.value.emplace(std::move(value));
+            }
+            if (slot.key == id) return *slot.value = std::move(value);
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> old = std::move(slots_);
+        const std::size_t capacity = old.empty() ? 16 : old.size() * 2;
+        slots_ = std::vector<Slot>(capacity);
+        shift_ = 64;
+        for (std::size_t c = capacity; c > 1; c >>= 1) --shift_;
+        size_ = 0;
+        for (auto& slot : old) {
+            if (slot.value) place(slot.key, std::move(*slot.value));
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+    unsigned shift_ = 64;
+};
+
+}  // namespace lab5
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sample.h"
+
+namespace lab5 {
+
+class Database;
+
+// Sensor names and their compact ids, persisted in the sensors table. Id 0 is the
+// "default" sensor that unnamed input and pre-sensor data belong to. Shared between
+// the ingest loop and HTTP handlers.
+class SensorRegistry {
+public:
+    bool load(Database& db, std::string& err);
+
+    // Id of name, registering it on first use; nullopt if it cannot be stored.
+    std::optional<SensorId> intern(Database& db, const std::string& name, std::string& err);
+    // Resolves a name or a decimal id as accepted by the sensor= query parameter.
+    std::optional<SensorId> find(const std::string& name_or_id) const;
+    std::vector<std::pair<SensorId, std::string>> list() const;
+
+private:
+    mutable std::mutex mu_;
+    std::unordered_map<std::string, SensorId> ids_;
+    std::vector<std::pair<SensorId, std::string>> sensors_;
+    SensorId next_id_ = kDefaultSensor + 1;
+};
+
+}  // namespace lab5
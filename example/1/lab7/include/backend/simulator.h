@@ -1,29 +1,64 @@
 ﻿#pragma once
 
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <thread>
+#include <vector>
 
+#include "mpsc_ring.h"
 #include "sample.h"
 
 namespace lab5 {
 
+struct SimulatorConfig {
+    std::uint64_t seed = 0;         // 0 -> seeded from the clock
+    bool fast_forward = false;      // virtual clock, samples produced as fast as they are consumed
+    std::int64_t start_ms = 0;      // virtual clock origin; 0 -> now
+    std::int64_t step_ms = 2000;    // interval between samples of one sensor
+    std::int64_t duration_ms = 0;   // fast-forward: virtual time to cover, 0 -> until stopped
+    std::size_t sensors = 0;        // 0 -> LAB7_SIM_SENSORS or 1 (used by run_main)
+    std::size_t threads = 0;        // 0 -> one worker per kSensorsPerWorker sensors, up to the core count
+    std::size_t queue_capacity = 1 << 16;
+    Overflow overflow = Overflow::kBlock;  // real time only; fast-forward always blocks
+};
+
+// Emits one temperature sample per sensor every step; each sensor has its own
+// mean, daily amplitude and phase, weather drift and noise. In real time the
+// daily cycle is sped up (10 minutes per step); in fast-forward it follows the
+// virtual clock. Sensors are split between worker threads that advance in
+// lockstep. Random numbers are a hash of (seed, sensor, step), so with a fixed
+// seed every sensor's series is the same on every run and for any thread count.
 class Simulator {
 public:
-    void start();
+    void start(const std::vector<SensorId>& sensors = {kDefaultSensor}, const SimulatorConfig& config = {});
     void stop();
+    // Blocks until a sample is available; false once stopped or the fast-forward duration is covered.
     bool pop(Sample& out);
+    // Same, but takes up to max queued samples at once; 0 means the stream ended.
+    std::size_t pop_batch(Sample* out, std::size_t max);
+    RingStats queue_stats() const;
+
+    // Sensors a worker is given before another one is started.
+    static constexpr std::size_t kSensorsPerWorker = 1024;
 
 private:
-    void run();
+    void run(std::size_t begin, std::size_t end);
+    // Waits for all workers to finish the step; false once stopped.
+    bool step_barrier();
 
+    SimulatorConfig config_;
+    std::vector<SensorId> sensors_;
     std::atomic<bool> running_{false};
-    std::thread thread_;
-    std::mutex mu_;
-    std::condition_variable cv_;
-    std::queue<Sample> queue_;
+    std::vector<std::thread> workers_;
+    std::size_t worker_count_ = 0;
+    std::atomic<std::size_t> active_{0};
+    std::unique_ptr<MpscRing<Sample>> queue_;
+
+    std::atomic<std::size_t> arrived_{0};
+    std::atomic<std::uint32_t> generation_{0};
+    WaitWord released_;
 };
 
 }  // namespace lab5
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace lab5 {
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Capacity is rounded up to a power of two; head and tail live on separate
+// cache lines so the two sides do not invalidate each other on every push.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        buf_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    // Producer side; false if the ring is full.
+    bool try_push(const T& v) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return false;
+        }
+        buf_[tail & mask_] = v;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side; copies as many of the n items as fit and publishes them
+    // with one store. Returns how many were pushed.
+    std::size_t try_push_batch(const T* v, std::size_t n) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t room = mask_ + 1 - (tail - head_cache_);
+        if (room < n) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            room = mask_ + 1 - (tail - head_cache_);
+        }
+        if (n > room) n = room;
+        for (std::size_t i = 0; i < n; ++i) buf_[(tail + i) & mask_] = v[i];
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side; moves up to max items into out and returns how many.
+    std::size_t pop_batch(T* out, std::size_t max) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ == head) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (tail_cache_ == head) return 0;
+        }
+        std::size_t n = tail_cache_ - head;
+        if (n > max) n = max;
+        for (std::size_t i = 0; i < n; ++i) out[i] = buf_[(head + i) & mask_];
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+private:
+    std::vector<T> buf_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;  // consumer's view of tail_
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;  // producer's view of head_
+};
+
+}  // namespace lab5
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef __linux__
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace lab5 {
+
+// Lets threads sleep until another thread reports a state change (an event
+// count). A waiter calls prepare_wait(), re-checks its condition, then either
+// wait()s or cancel_wait()s; a notifier changes the state and calls notify().
+// notify() costs one fence and no syscall while nobody sleeps. Linux uses a
+// futex, other platforms a condition variable.
+class WaitWord {
+public:
+    std::uint32_t prepare_wait();
+    void wait(std::uint32_t ticket);
+    void cancel_wait();
+    // Returns true if sleeping threads had to be woken.
+    bool notify();
+
+private:
+    std::atomic<std::uint32_t> word_{0};
+    std::atomic<std::uint32_t> sleepers_{0};
+#ifndef __linux__
+    std::mutex mu_;
+    std::condition_variable cv_;
+#endif
+};
+
+}  // namespace lab5
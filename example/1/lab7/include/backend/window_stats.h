@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lab5 {
+
+// Time-based sliding window over the latest span_ms of samples. The mean comes
+// from a running sum, min/max from monotonic deques, so add() is amortised O(1)
+// and every query is O(1).
+class SlidingWindow {
+public:
+    explicit SlidingWindow(std::int64_t span_ms = 0) : span_ms_(span_ms) {}
+
+    void add(std::int64_t epoch_ms, double value);
+    void save(std::ostream& out) const;
+
+    std::int64_t span_ms() const { return span_ms_; }
+    std::size_t count() const { return points_.size(); }
+    double avg() const { return points_.empty() ? 0.0 : sum_ / static_cast<double>(points_.size()); }
+    double min() const { return min_q_.empty() ? 0.0 : min_q_.front().value; }
+    double max() const { return max_q_.empty() ? 0.0 : max_q_.front().value; }
+
+private:
+    struct Point {
+        std::int64_t epoch_ms;
+        double value;
+    };
+
+    void expire(std::int64_t now_ms);
+
+    std::int64_t span_ms_;
+    double sum_ = 0.0;
+    std::deque<Point> points_;
+    std::deque<Point> min_q_;  // increasing values
+    std::deque<Point> max_q_;  // decreasing values
+};
+
+struct WindowSnapshot {
+    std::string name;
+    std::size_t count = 0;
+    double avg = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Several windows fed from the same sample stream (e.g. "5m" and "1h").
+class WindowSet {
+public:
+    // names are steps as accepted by parse_step ("30s", "5m", "1h"); invalid ones are skipped.
+    explicit WindowSet(const std::vector<std::string>& names);
+
+    void add(std::int64_t epoch_ms, double value);
+    void snapshot(std::vector<WindowSnapshot>& out) const;
+
+    // Window contents for warm restart. Every window holds a suffix of the same
+    // stream, so only the longest one's points are saved and load() replays them
+    // into all configured windows.
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+private:
+    std::vector<std::string> names_;
+    std::vector<SlidingWindow> windows_;
+};
+
+}  // namespace lab5
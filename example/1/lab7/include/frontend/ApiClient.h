@@ -18,7 +18,8 @@ public:
 
     void setBaseUrl(const QUrl& url);
     void fetchCurrent();
-    void fetchStats(const QString& bucket, qint64 startMs, qint64 endMs);
+    // bucket "auto" (or maxPoints > 0) lets the server pick rollup tiers for the range.
+    void fetchStats(const QString& bucket, qint64 startMs, qint64 endMs, int maxPoints = 0);
 
 signals:
     void currentReceived(double value, qint64 epochMs);
@@ -0,0 +1,172 @@
+#include "aggregate.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <sstream>
+
+#include "rollup.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LAB_AGG_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define LAB_AGG_NEON 1
+#endif
+
+namespace lab5 {
+
+namespace {
+
+struct RunStats {
+    double sum;
+    double min;
+    double max;
+};
+
+// Sum/min/max of v[0..n), n > 0. Two 2-lane accumulators per statistic hide the
+// add latency; the tail is handled in scalar code.
+RunStats reduce_run(const double* v, std::size_t n) {
+    std::size_t i = 0;
+    double sum = 0.0;
+    double mn = v[0];
+    double mx = v[0];
+#if defined(LAB_AGG_SSE2)
+    if (n >= 4) {
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+        __m128d lo0 = _mm_loadu_pd(v), lo1 = _mm_loadu_pd(v + 2);
+        __m128d hi0 = lo0, hi1 = lo1;
+        for (; i + 4 <= n; i += 4) {
+            const __m128d a = _mm_loadu_pd(v + i);
+            const __m128d b = _mm_loadu_pd(v + i + 2);
+            s0 = _mm_add_pd(s0, a);
+            s1 = _mm_add_pd(s1, b);
+            lo0 = _mm_min_pd(lo0, a);
+            lo1 = _mm_min_pd(lo1, b);
+            hi0 = _mm_max_pd(hi0, a);
+            hi1 = _mm_max_pd(hi1, b);
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(s0, s1));
+        sum = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, _mm_min_pd(lo0, lo1));
+        mn = std::min(lanes[0], lanes[1]);
+        _mm_storeu_pd(lanes, _mm_max_pd(hi0, hi1));
+        mx = std::max(lanes[0], lanes[1]);
+    }
+#elif defined(LAB_AGG_NEON)
+    if (n >= 4) {
+        float64x2_t s0 = vdupq_n_f64(0.0), s1 = vdupq_n_f64(0.0);
+        float64x2_t lo0 = vld1q_f64(v), lo1 = vld1q_f64(v + 2);
+        float64x2_t hi0 = lo0, hi1 = lo1;
+        for (; i + 4 <= n; i += 4) {
+            const float64x2_t a = vld1q_f64(v + i);
+            const float64x2_t b = vld1q_f64(v + i + 2);
+            s0 = vaddq_f64(s0, a);
+            s1 = vaddq_f64(s1, b);
+            lo0 = vminq_f64(lo0, a);
+            lo1 = vminq_f64(lo1, b);
+            hi0 = vmaxq_f64(hi0, a);
+            hi1 = vmaxq_f64(hi1, b);
+        }
+        sum = vaddvq_f64(vaddq_f64(s0, s1));
+        mn = vminvq_f64(vminq_f64(lo0, lo1));
+        mx = vmaxvq_f64(vmaxq_f64(hi0, hi1));
+    }
+#endif
+    for (; i < n; ++i) {
+        sum += v[i];
+        mn = std::min(mn, v[i]);
+        mx = std::max(mx, v[i]);
+    }
+    return {sum, mn, mx};
+}
+
+std::int64_t floor_div(std::int64_t a, std::int64_t b) {
+    const std::int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Hour and day steps that tile a day follow local time, like hourly_avg/daily_avg.
+bool local_aligned(std::int64_t step_ms) {
+    constexpr std::int64_t kHourMs = 60LL * 60 * 1000;
+    return step_ms == kDayMs || (step_ms >= kHourMs && step_ms < kDayMs && kDayMs % step_ms == 0);
+}
+
+}  // namespace
+
+std::optional<std::int64_t> parse_step(const std::string& text) {
+    std::int64_t n = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), n);
+    if (ec != std::errc() || n <= 0) return std::nullopt;
+    const std::string unit(end, text.data() + text.size());
+    std::int64_t mul = 0;
+    if (unit.empty() || unit == "ms") mul = 1;
+    else if (unit == "s") mul = 1000;
+    else if (unit == "m") mul = 60LL * 1000;
+    else if (unit == "h") mul = 60LL * 60 * 1000;
+    else if (unit == "d") mul = 24LL * 60 * 60 * 1000;
+    else return std::nullopt;
+    if (n > std::numeric_limits<std::int64_t>::max() / mul) return std::nullopt;
+    return n * mul;
+}
+
+std::vector<AggFn> parse_agg_fns(const std::string& text) {
+    std::vector<AggFn> fns;
+    std::istringstream iss(text);
+    std::string name;
+    while (std::getline(iss, name, ',')) {
+        if (name == "avg") fns.push_back(kAggAvg);
+        else if (name == "min") fns.push_back(kAggMin);
+        else if (name == "max") fns.push_back(kAggMax);
+        else if (name == "sum") fns.push_back(kAggSum);
+        else if (name == "count") fns.push_back(kAggCount);
+        else return {};
+    }
+    return fns;
+}
+
+const char* agg_fn_name(AggFn fn) {
+    switch (fn) {
+    case kAggAvg: return "avg";
+    case kAggMin: return "min";
+    case kAggMax: return "max";
+    case kAggSum: return "sum";
+    case kAggCount: return "count";
+    }
+    return "";
+}
+
+void aggregate_columns(const std::int64_t* ts, const double* values, std::size_t n, std::int64_t step_ms,
+                       std::vector<AggBucket>& out) {
+    const bool local = local_aligned(step_ms);
+    std::size_t i = 0;
+    while (i < n) {
+        std::int64_t start = floor_div(ts[i], step_ms) * step_ms;
+        std::int64_t end = start + step_ms;
+        if (local) {
+            const std::int64_t s = bucket_start(ts[i], step_ms);
+            const std::int64_t e = bucket_end(s, step_ms);
+            // An ambiguous DST hour can resolve to the other offset; keep the epoch bucket then.
+            if (s <= ts[i] && ts[i] < e) {
+                start = s;
+                end = e;
+            }
+        }
+        // Gallop to bracket the end of the run, then binary search inside the bracket.
+        std::size_t lo = i + 1;
+        std::size_t span = 1;
+        while (lo + span < n && ts[lo + span] < end) {
+            lo += span;
+            span *= 2;
+        }
+        const std::size_t hi = std::min(n, lo + span + 1);
+        const std::size_t j = static_cast<std::size_t>(std::lower_bound(ts + lo, ts + hi, end) - ts);
+        const auto run = reduce_run(values + i, j - i);
+        out.push_back(AggBucket{start, j - i, run.sum, run.min, run.max});
+        i = j;
+    }
+}
+
+}  // namespace lab5
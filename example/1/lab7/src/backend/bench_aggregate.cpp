@@ -0,0 +1,134 @@
+// Benchmark: /api/aggregate kernel vs the equivalent SQLite GROUP BY.
+// Usage: lab7_bench_aggregate [rows=1000000] [step=5m]
+// The GROUP BY reference is epoch-aligned; run hour/day steps with TZ=UTC.
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "aggregate.h"
+#include "db.h"
+
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+namespace {
+
+double seconds_since(steady_clock::time_point t0) {
+    return duration<double>(steady_clock::now() - t0).count();
+}
+
+bool fill(sqlite3* db, std::int64_t base_ms, std::size_t rows) {
+    sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr);
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT INTO measurements(epoch_ms, iso, value) VALUES(?, '', ?)", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    for (std::size_t i = 0; i < rows; ++i) {
+        const double value = 15.0 + 7.0 * std::sin(static_cast<double>(i) * 1e-4) + static_cast<double>(i % 17) * 0.01;
+        sqlite3_bind_int64(stmt, 1, base_ms + static_cast<std::int64_t>(i) * 2000);
+        sqlite3_bind_double(stmt, 2, value);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t rows = argc > 1 ? static_cast<std::size_t>(std::stoull(argv[1])) : 1000000;
+    const auto step = lab5::parse_step(argc > 2 ? argv[2] : "5m");
+    if (!step) {
+        std::cerr << "invalid step\n";
+        return 1;
+    }
+
+    const auto path = (fs::temp_directory_path() / "lab7_bench_aggregate.db").string();
+    std::error_code ec;
+    fs::remove(path, ec);
+
+    lab5::Database db;
+    std::string err;
+    if (!db.open(path, err)) {
+        std::cerr << "DB open failed: " << err << "\n";
+        return 1;
+    }
+    sqlite3* raw = nullptr;
+    if (sqlite3_open(path.c_str(), &raw) != SQLITE_OK) return 1;
+
+    const std::int64_t base = 1700000000000LL;
+    const std::int64_t last = base + static_cast<std::int64_t>(rows) * 2000;
+    auto t0 = steady_clock::now();
+    if (!fill(raw, base, rows)) {
+        std::cerr << "fill failed: " << sqlite3_errmsg(raw) << "\n";
+        return 1;
+    }
+    std::printf("rows=%zu step=%lldms fill=%.2fs\n", rows, static_cast<long long>(*step), seconds_since(t0));
+
+    // 1) SQLite GROUP BY epoch_ms/step.
+    t0 = steady_clock::now();
+    const std::string sql = "SELECT (epoch_ms/" + std::to_string(*step) + ")*" + std::to_string(*step) +
+                            ", COUNT(*), AVG(value), MIN(value), MAX(value) FROM measurements WHERE epoch_ms BETWEEN ? AND ?"
+                            " GROUP BY epoch_ms/" + std::to_string(*step) + " ORDER BY 1";
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(raw, sql.c_str(), -1, &stmt, nullptr);
+    sqlite3_bind_int64(stmt, 1, base);
+    sqlite3_bind_int64(stmt, 2, last);
+    std::vector<lab5::AggBucket> expected;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        lab5::AggBucket b;
+        b.start_ms = sqlite3_column_int64(stmt, 0);
+        b.count = static_cast<std::size_t>(sqlite3_column_int64(stmt, 1));
+        b.sum = sqlite3_column_double(stmt, 2) * static_cast<double>(b.count);
+        b.min = sqlite3_column_double(stmt, 3);
+        b.max = sqlite3_column_double(stmt, 4);
+        expected.push_back(b);
+    }
+    sqlite3_finalize(stmt);
+    const double sql_s = seconds_since(t0);
+
+    // 2) Column scan + kernel, as served by /api/aggregate.
+    t0 = steady_clock::now();
+    std::vector<std::int64_t> ts;
+    std::vector<double> values;
+    db.query_columns("measurements", lab5::kDefaultSensor, base, last, ts, values, err);
+    const double scan_s = seconds_since(t0);
+    t0 = steady_clock::now();
+    std::vector<lab5::AggBucket> got;
+    lab5::aggregate_columns(ts.data(), values.data(), ts.size(), *step, got);
+    const double kernel_s = seconds_since(t0);
+
+    // 3) Kernel alone, averaged over several runs.
+    constexpr int reps = 20;
+    t0 = steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        std::vector<lab5::AggBucket> tmp;
+        tmp.reserve(got.size());
+        lab5::aggregate_columns(ts.data(), values.data(), ts.size(), *step, tmp);
+    }
+    const double kernel_avg_s = seconds_since(t0) / reps;
+
+    bool same = expected.size() == got.size();
+    for (std::size_t i = 0; same && i < got.size(); ++i) {
+        same = expected[i].start_ms == got[i].start_ms && expected[i].count == got[i].count &&
+               expected[i].min == got[i].min && expected[i].max == got[i].max &&
+               std::fabs(expected[i].sum - got[i].sum) < 1e-6 * std::fabs(got[i].sum) + 1e-9;
+    }
+
+    std::printf("buckets=%zu results %s\n", got.size(), same ? "match" : "DIFFER");
+    std::printf("sqlite GROUP BY      : %8.2f ms\n", sql_s * 1e3);
+    std::printf("column scan (sqlite) : %8.2f ms\n", scan_s * 1e3);
+    std::printf("aggregate kernel     : %8.2f ms (first), %.2f ms avg, %.0f Mrows/s\n", kernel_s * 1e3, kernel_avg_s * 1e3,
+                static_cast<double>(rows) / kernel_avg_s / 1e6);
+
+    sqlite3_close(raw);
+    fs::remove(path, ec);
+    return same ? 0 : 2;
+}
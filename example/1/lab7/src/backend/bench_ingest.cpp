@@ -0,0 +1,84 @@
+// Benchmark: sharded ingest throughput for 1..max shards.
+// Usage: lab7_bench_ingest [sensors=256] [samples_per_sensor=4000] [max_shards=hardware threads]
+// "memory" runs aggregate only; "sqlite" runs also write raw rows and rollups to
+// a temporary DB, where every shard competes for SQLite's single writer lock.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ingest.h"
+
+using namespace std::chrono;
+namespace fs = std::filesystem;
+
+namespace {
+
+double run(const std::vector<lab5::Sample>& input, std::size_t shard_count, bool store, const std::string& path) {
+    std::error_code ec;
+    for (const char* suffix : {"", "-wal", "-shm"}) fs::remove(path + suffix, ec);
+
+    lab5::IngestConfig config;
+    config.windows = {"1m", "5m"};
+    config.store = store;
+    std::vector<std::unique_ptr<lab5::IngestShard>> shards;
+    std::string err;
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        shards.push_back(std::make_unique<lab5::IngestShard>(i, config));
+        if (!shards.back()->open(path, err)) {
+            std::fprintf(stderr, "DB open failed: %s\n", err.c_str());
+            return 0.0;
+        }
+    }
+    const unsigned cores = std::thread::hardware_concurrency();
+    for (std::size_t i = 0; i < shard_count; ++i) shards[i]->start(cores > 1 ? static_cast<int>(i % cores) : -1);
+
+    const auto t0 = steady_clock::now();
+    for (const auto& s : input) shards[lab5::shard_for(s.sensor, shard_count)]->push(s);
+    for (auto& shard : shards) shard->stop();
+    const double secs = duration<double>(steady_clock::now() - t0).count();
+
+    std::uint64_t processed = 0;
+    for (auto& shard : shards) processed += shard->processed();
+    if (processed != input.size()) std::fprintf(stderr, "lost samples: %llu of %zu\n", static_cast<unsigned long long>(processed), input.size());
+    return static_cast<double>(input.size()) / secs;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t sensors = argc > 1 ? std::stoul(argv[1]) : 256;
+    const std::size_t per_sensor = argc > 2 ? std::stoul(argv[2]) : 4000;
+    const std::size_t max_shards = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+    // Interleaved streams, one sample per sensor per second.
+    std::vector<lab5::Sample> input;
+    input.reserve(sensors * per_sensor);
+    const std::int64_t base = 1700000000000LL;
+    for (std::size_t t = 0; t < per_sensor; ++t) {
+        for (std::size_t id = 0; id < sensors; ++id) {
+            const double value = 15.0 + 7.0 * std::sin(static_cast<double>(t) * 1e-3 + static_cast<double>(id));
+            input.push_back({lab5::TimePoint(milliseconds(base + static_cast<std::int64_t>(t) * 1000)), value,
+                             static_cast<lab5::SensorId>(id)});
+        }
+    }
+    std::printf("sensors=%zu samples=%zu cores=%u\n", sensors, input.size(), std::thread::hardware_concurrency());
+
+    const auto path = (fs::temp_directory_path() / "lab7_bench_ingest.db").string();
+    for (bool store : {false, true}) {
+        double single = 0.0;
+        for (std::size_t shards = 1; shards <= max_shards; shards *= 2) {
+            const double rate = run(input, shards, store, path);
+            if (shards == 1) single = rate;
+            std::printf("%-6s shards=%-3zu %10.0f samples/s  x%.2f\n", store ? "sqlite" : "memory", shards, rate,
+                        single > 0 ? rate / single : 0.0);
+        }
+    }
+    std::error_code ec;
+    for (const char* suffix : {"", "-wal", "-shm"}) fs::remove(path + suffix, ec);
+    return 0;
+}
@@ -0,0 +1,150 @@
+// Benchmark: simulator queue, MPSC ring against the old mutex + condition_variable queue.
+// Usage: lab7_bench_ring [samples=2000000] [max_producers=4] [capacity=65536]
+// Each run splits the samples between P producers; one consumer drains batches
+// of 256. The ring reports its contention counters: lost CAS races, waits on a
+// full/empty ring and notifications that had to wake a sleeping thread.
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpsc_ring.h"
+#include "sample.h"
+
+using namespace std::chrono;
+
+namespace {
+
+constexpr std::size_t kBatch = 256;
+
+// The queue the Simulator used before: bounded by a second condition variable.
+class MutexQueue {
+public:
+    explicit MutexQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    void push(const lab5::Sample& s) {
+        std::unique_lock<std::mutex> lk(mu_);
+        if (queue_.size() >= capacity_) {
+            ++producer_waits;
+            space_cv_.wait(lk, [&] { return queue_.size() < capacity_; });
+        }
+        queue_.push(s);
+        lk.unlock();
+        cv_.notify_one();
+    }
+
+    std::size_t pop_batch(lab5::Sample* out, std::size_t max) {
+        std::unique_lock<std::mutex> lk(mu_);
+        if (queue_.empty() && !closed_) ++consumer_waits;
+        cv_.wait(lk, [&] { return !queue_.empty() || closed_; });
+        std::size_t n = 0;
+        for (; n < max && !queue_.empty(); ++n) {
+            out[n] = queue_.front();
+            queue_.pop();
+        }
+        lk.unlock();
+        space_cv_.notify_all();
+        return n;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    std::uint64_t producer_waits = 0;
+    std::uint64_t consumer_waits = 0;
+
+private:
+    const std::size_t capacity_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::condition_variable space_cv_;
+    std::queue<lab5::Sample> queue_;
+    bool closed_ = false;
+};
+
+template <typename Queue>
+double run(Queue& queue, std::size_t samples, std::size_t producers, std::uint64_t& received) {
+    const auto t0 = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p, producers, samples] {
+            lab5::Sample s;
+            s.sensor = static_cast<lab5::SensorId>(p);
+            for (std::size_t i = p; i < samples; i += producers) {
+                s.value = static_cast<double>(i);
+                queue.push(s);
+            }
+        });
+    }
+    std::thread closer([&] {
+        for (auto& t : threads) t.join();
+        queue.close();
+    });
+
+    std::vector<lab5::Sample> batch(kBatch);
+    received = 0;
+    while (const std::size_t n = queue.pop_batch(batch.data(), batch.size())) received += n;
+    closer.join();
+    return duration<double>(steady_clock::now() - t0).count();
+}
+
+const char* name_of(lab5::Overflow overflow) {
+    switch (overflow) {
+    case lab5::Overflow::kBlock: return "block";
+    case lab5::Overflow::kDropNewest: return "drop-newest";
+    case lab5::Overflow::kDropOldest: return "drop-oldest";
+    }
+    return "?";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t samples = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    const std::size_t max_producers = argc > 2 ? std::stoul(argv[2]) : 4;
+    const std::size_t capacity = argc > 3 ? std::stoul(argv[3]) : 1 << 16;
+
+    std::printf("%zu samples, capacity %zu, batch %zu, %u hardware threads\n", samples, capacity, kBatch,
+                std::thread::hardware_concurrency());
+    std::printf("%-12s %-12s %3s %12s %10s %10s %10s %10s %10s\n", "queue", "overflow", "P", "samples/s", "dropped",
+                "cas_retry", "prod_wait", "cons_wait", "wakeups");
+
+    for (std::size_t producers = 1; producers <= max_producers; producers *= 2) {
+        {
+            MutexQueue queue(capacity);
+            std::uint64_t received = 0;
+            const double secs = run(queue, samples, producers, received);
+            std::printf("%-12s %-12s %3zu %12.0f %10s %10s %10llu %10llu %10s\n", "mutex+cv", "block", producers,
+                        static_cast<double>(received) / secs, "-", "-",
+                        static_cast<unsigned long long>(queue.producer_waits),
+                        static_cast<unsigned long long>(queue.consumer_waits), "-");
+        }
+        for (auto overflow : {lab5::Overflow::kBlock, lab5::Overflow::kDropNewest, lab5::Overflow::kDropOldest}) {
+            lab5::MpscRing<lab5::Sample> queue(capacity, overflow);
+            std::uint64_t received = 0;
+            const double secs = run(queue, samples, producers, received);
+            const lab5::RingStats st = queue.stats();
+            if (received + st.dropped != samples) {
+                std::fprintf(stderr, "lost samples: %llu received + %llu dropped of %zu\n",
+                             static_cast<unsigned long long>(received), static_cast<unsigned long long>(st.dropped),
+                             samples);
+            }
+            std::printf("%-12s %-12s %3zu %12.0f %10llu %10llu %10llu %10llu %10llu\n", "mpsc_ring", name_of(overflow),
+                        producers, static_cast<double>(received) / secs, static_cast<unsigned long long>(st.dropped),
+                        static_cast<unsigned long long>(st.cas_retries),
+                        static_cast<unsigned long long>(st.producer_waits),
+                        static_cast<unsigned long long>(st.consumer_waits),
+                        static_cast<unsigned long long>(st.wakeups));
+        }
+    }
+    return 0;
+}
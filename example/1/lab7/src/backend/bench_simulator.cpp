@@ -0,0 +1,74 @@
+// Benchmark: fast-forward simulator throughput for 1..max worker threads.
+// Usage: lab7_bench_simulator [sensors=4096] [steps=500] [max_threads=hardware threads]
+// The consumer only drains the queue, so this is the generator's ceiling. The
+// checksum over (sensor, step, value) must match for every thread count.
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "simulator.h"
+
+using namespace std::chrono;
+
+namespace {
+
+struct Result {
+    double seconds = 0.0;
+    std::uint64_t samples = 0;
+    std::uint64_t checksum = 0;
+};
+
+Result run(const std::vector<lab5::SensorId>& sensors, std::size_t steps, std::size_t threads) {
+    lab5::SimulatorConfig config;
+    config.seed = 42;
+    config.fast_forward = true;
+    config.start_ms = 1735689600000;  // 2025-01-01 UTC
+    config.step_ms = 1000;
+    config.duration_ms = static_cast<std::int64_t>(steps) * config.step_ms;
+    config.threads = threads;
+
+    lab5::Simulator sim;
+    const auto t0 = steady_clock::now();
+    sim.start(sensors, config);
+    std::vector<lab5::Sample> batch(4096);
+    Result r;
+    while (const std::size_t n = sim.pop_batch(batch.data(), batch.size())) {
+        for (std::size_t i = 0; i < n; ++i) {
+            // Order-independent: workers interleave differently on every run.
+            std::uint64_t bits;
+            std::memcpy(&bits, &batch[i].value, sizeof bits);
+            const auto ts = static_cast<std::uint64_t>(batch[i].ts.time_since_epoch().count());
+            r.checksum += (bits ^ (ts * 0x9e3779b97f4a7c15ULL)) * (2 * batch[i].sensor + 1);
+        }
+        r.samples += n;
+    }
+    r.seconds = duration<double>(steady_clock::now() - t0).count();
+    sim.stop();
+    return r;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::size_t sensor_count = argc > 1 ? std::stoul(argv[1]) : 4096;
+    const std::size_t steps = argc > 2 ? std::stoul(argv[2]) : 500;
+    const std::size_t max_threads = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<lab5::SensorId> sensors(sensor_count);
+    for (std::size_t i = 0; i < sensor_count; ++i) sensors[i] = static_cast<lab5::SensorId>(i);
+
+    std::printf("%zu sensors x %zu steps\n", sensor_count, steps);
+    std::printf("%8s %14s %12s %18s\n", "threads", "samples", "samples/s", "checksum");
+    std::uint64_t expected = 0;
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        const Result r = run(sensors, steps, threads);
+        if (threads == 1) expected = r.checksum;
+        std::printf("%8zu %14llu %12.0f %18llx%s\n", threads, static_cast<unsigned long long>(r.samples),
+                    static_cast<double>(r.samples) / r.seconds, static_cast<unsigned long long>(r.checksum),
+                    r.checksum == expected ? "" : "  MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "bulk_input.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace lab5 {
+
+namespace {
+
+const char* skip_spaces(const char* p, const char* end) {
+    while (p != end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+}  // namespace
+
+bool parse_bulk_line(const char* begin, const char* end, std::int64_t now, std::int64_t& epoch_ms, double& value) {
+    if (end != begin && end[-1] == '\r') --end;
+    const char* p = skip_spaces(begin, end);
+    if (p == end) return false;
+
+    std::int64_t ms = 0;
+    auto r = std::from_chars(p, end, ms);
+    const char* v = r.ec == std::errc() ? skip_spaces(r.ptr, end) : p;
+    // An integer followed only by blanks is a plain value ("21 "), not a timestamp.
+    if (v != r.ptr && v != end) {
+        auto rv = std::from_chars(v, end, value);
+        if (rv.ec == std::errc() && skip_spaces(rv.ptr, end) == end) {
+            epoch_ms = ms;
+            return true;
+        }
+        return false;
+    }
+    r = std::from_chars(p, end, value);
+    if (r.ec != std::errc() || skip_spaces(r.ptr, end) != end) return false;
+    epoch_ms = now;
+    return true;
+}
+
+BulkReader::BulkReader(std::FILE* in, std::size_t block_size) : in_(in), buf_(block_size) {}
+
+bool BulkReader::refill() {
+    if (eof_) return false;
+    // Keep the partial last line; grow only if a single line fills the buffer.
+    if (begin_ != 0) {
+        std::memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (end_ == buf_.size()) buf_.resize(buf_.size() * 2);
+    const std::size_t got = std::fread(buf_.data() + end_, 1, buf_.size() - end_, in_);
+    if (got == 0) eof_ = true;
+    end_ += got;
+    return got != 0;
+}
+
+std::size_t BulkReader::next_batch(Sample* out, std::size_t max) {
+    const std::int64_t now = now_ms();
+    std::size_t n = 0;
+    while (n < max) {
+        const auto* nl = static_cast<const char*>(std::memchr(buf_.data() + begin_, '\n', end_ - begin_));
+        if (!nl && refill()) continue;
+        const char* base = buf_.data();
+        const char* line = base + begin_;
+        const char* line_end = nl;
+        if (!nl) {
+            if (begin_ == end_) break;
+            line_end = base + end_;  // last line without '\n'
+        }
+        begin_ = static_cast<std::size_t>(line_end - base) + (nl ? 1 : 0);
+        if (line == line_end || (line_end - line == 1 && *line == '\r')) continue;
+
+        ++lines_;
+        std::int64_t ms = 0;
+        double value = 0.0;
+        if (!parse_bulk_line(line, line_end, now, ms, value)) {
+            ++skipped_;
+            continue;
+        }
+        out[n++] = Sample{TimePoint(std::chrono::milliseconds(ms)), value, kDefaultSensor};
+    }
+    return n;
+}
+
+}  // namespace lab5
@@ -0,0 +1,124 @@
+#include "checkpoint.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace lab5 {
+
+namespace {
+constexpr const char* kMagic = "lab7-checkpoint";
+constexpr int kVersion = 1;
+
+// Flushes a file (or, on POSIX, a directory entry list) to stable storage.
+bool sync_path(const fs::path& path, bool directory) {
+#ifdef _WIN32
+    if (directory) return true;  // NTFS has no directory fsync; MoveFileEx is journaled
+    FILE* f = _wfopen(path.c_str(), L"r+b");
+    if (!f) return false;
+    const bool ok = _commit(_fileno(f)) == 0;
+    std::fclose(f);
+    return ok;
+#else
+    const int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_WRONLY);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+}  // namespace
+
+bool save_checkpoint(const std::string& path, std::int64_t saved_ms, const std::vector<SensorAggregates>& sensors,
+                     std::string& err) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out.is_open()) {
+            err = "cannot write " + tmp;
+            return false;
+        }
+        out.precision(std::numeric_limits<double>::max_digits10);
+        out << kMagic << ' ' << kVersion << '\n' << "saved " << saved_ms << '\n';
+        out << "sensors " << sensors.size() << '\n';
+        for (const auto& sensor : sensors) {
+            out << "sensor " << sensor.sensor << ' ' << sensor.applied_ms << '\n';
+            sensor.rollups.save(out);
+            sensor.windows.save(out);
+        }
+        out << "end\n";
+        out.flush();
+        if (!out) {
+            err = "short write to " + tmp;
+            return false;
+        }
+    }
+    // Without the syncs a crash shortly after the rename can leave an empty or
+    // missing checkpoint in place of the previous good one.
+    if (!sync_path(tmp, false)) {
+        err = "cannot sync " + tmp;
+        return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        err = ec.message();
+        return false;
+    }
+    const fs::path dir = fs::absolute(fs::path(path), ec).parent_path();
+    if (ec || !sync_path(dir, true)) {
+        err = "cannot sync " + dir.string();
+        return false;
+    }
+    return true;
+}
+
+bool load_checkpoint(const std::string& path, const WindowSet& windows, const RestoreSensor& restore, std::string& err) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+    std::string magic, tag, end;
+    int version = 0;
+    std::int64_t saved_ms = 0;
+    if (!(in >> magic >> version >> tag >> saved_ms) || magic != kMagic || version != kVersion || tag != "saved") {
+        err = "unrecognised checkpoint " + path;
+        return false;
+    }
+    std::size_t count = 0;
+    if (!(in >> tag >> count) || tag != "sensors") {
+        err = "truncated checkpoint " + path;
+        return false;
+    }
+    std::vector<SensorAggregates> loaded;
+    for (std::size_t i = 0; i < count; ++i) {
+        SensorId sensor = kDefaultSensor;
+        std::int64_t applied_ms = 0;
+        if (!(in >> tag >> sensor >> applied_ms) || tag != "sensor") {
+            err = "truncated checkpoint " + path;
+            return false;
+        }
+        SensorAggregates state{sensor, applied_ms, RollupCascade(sensor), windows};
+        if (!state.rollups.load(in) || !state.windows.load(in)) {
+            err = "truncated checkpoint " + path;
+            return false;
+        }
+        loaded.push_back(std::move(state));
+    }
+    if (!(in >> end) || end != "end") {
+        err = "truncated checkpoint " + path;
+        return false;
+    }
+    for (auto& state : loaded) restore(std::move(state));
+    return true;
+}
+
+}  // namespace lab5
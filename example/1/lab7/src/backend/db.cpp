@@ -1,7 +1,10 @@
 ﻿#include "db.h"
 
 #include <sqlite3.h>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <limits>
 #include <sstream>
 
 namespace lab5 {
@@ -23,48 +26,213 @@ bool Database::exec(const std::string& sql, std::string& err) {
     return true;
 }
 
+bool Database::table_columns(const std::string& table, std::vector<std::string>& columns, std::string& err) {
+    const std::string sql = "PRAGMA table_info(" + table + ")";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const auto* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        columns.emplace_back(name ? name : "");
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::create_series_table(const std::string& table, bool unique_time, std::string& err) {
+    std::ostringstream ddl;
+    ddl << "CREATE TABLE IF NOT EXISTS " << table << "(sensor_id INTEGER NOT NULL DEFAULT 0, epoch_ms INTEGER NOT NULL, iso TEXT, value REAL";
+    if (unique_time) {
+        ddl << ", PRIMARY KEY(sensor_id, epoch_ms)) WITHOUT ROWID;";
+    } else {
+        ddl << ");CREATE INDEX IF NOT EXISTS " << table << "_sensor_epoch ON " << table << "(sensor_id, epoch_ms);";
+    }
+    ddl << "CREATE INDEX IF NOT EXISTS " << table << "_epoch ON " << table << "(epoch_ms);";
+    auto is_legacy = [&](bool& legacy) {
+        std::vector<std::string> columns;
+        if (!table_columns(table, columns, err)) return false;
+        legacy = !columns.empty() && std::find(columns.begin(), columns.end(), "sensor_id") == columns.end();
+        return true;
+    };
+    bool legacy = false;
+    if (!is_legacy(legacy)) return false;
+    if (!legacy) return exec(ddl.str(), err);
+
+    // The copy runs in one write transaction, so a failure leaves the old table as
+    // it was. The layout is checked again under the lock in case another connection
+    // (ingest shard, rebuild tool) migrated it first.
+    if (!exec("BEGIN IMMEDIATE;", err)) return false;
+    bool ok = is_legacy(legacy);
+    if (ok) {
+        std::ostringstream migrate;
+        if (legacy) migrate << "ALTER TABLE " << table << " RENAME TO " << table << "_v1;";
+        migrate << ddl.str();
+        if (legacy) {
+            migrate << "INSERT OR IGNORE INTO " << table << "(sensor_id, epoch_ms, iso, value) SELECT " << kDefaultSensor
+                    << ", epoch_ms, iso, value FROM " << table << "_v1;"
+                    << "DROP TABLE " << table << "_v1;";
+        }
+        ok = exec(migrate.str(), err);
+    }
+    if (!ok) {
+        std::string ignored;
+        exec("ROLLBACK;", ignored);
+        return false;
+    }
+    return exec("COMMIT;", err);
+}
+
 bool Database::open(const std::string& path, std::string& err) {
     if (sqlite3_open(path.c_str(), &db_) != SQLITE_OK) {
         err = sqlite3_errmsg(db_);
         return false;
     }
-    const char* ddl = R"(
-        PRAGMA journal_mode=WAL;
-        CREATE TABLE IF NOT EXISTS measurements(epoch_ms INTEGER PRIMARY KEY, iso TEXT, value REAL);
-        CREATE TABLE IF NOT EXISTS hourly_avg(epoch_ms INTEGER PRIMARY KEY, iso TEXT, value REAL);
-        CREATE TABLE IF NOT EXISTS daily_avg(epoch_ms INTEGER PRIMARY KEY, iso TEXT, value REAL);
-    )";
-    return exec(ddl, err);
+    // Ingest and the rollup rebuild tool write to the same file; wait for the lock instead of failing.
+    sqlite3_busy_timeout(db_, 5000);
+    std::ostringstream ddl;
+    ddl << "PRAGMA journal_mode=WAL;"
+        << "CREATE TABLE IF NOT EXISTS sensors(id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);"
+        << "INSERT OR IGNORE INTO sensors(id, name) VALUES(" << kDefaultSensor << ", 'default');";
+    if (!exec(ddl.str(), err) || !create_series_table("measurements", false, err)) return false;
+    for (const auto& level : kRollupLevels) {
+        if (!create_series_table(level.table, true, err)) return false;
+    }
+    return true;
+}
+
+bool Database::load_sensors(std::vector<std::pair<SensorId, std::string>>& out, std::string& err) {
+    const char* sql = "SELECT id, name FROM sensors ORDER BY id";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const auto* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        out.emplace_back(static_cast<SensorId>(sqlite3_column_int64(stmt, 0)), name ? name : "");
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::insert_sensor(SensorId id, const std::string& name, std::string& err) {
+    const char* sql = "INSERT INTO sensors(id, name) VALUES(?, ?)";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, id);
+    sqlite3_bind_text(stmt, 2, name.c_str(), static_cast<int>(name.size()), SQLITE_TRANSIENT);
+    const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!ok) err = sqlite3_errmsg(db_);
+    sqlite3_finalize(stmt);
+    return ok;
 }
 
 bool Database::insert_measurement(const Sample& s, std::string& err) {
+    char iso[kIsoTimeLen + 1];
+    format_iso_time(s.ts, iso);
     std::ostringstream oss;
-    oss << "INSERT INTO measurements(epoch_ms, iso, value) VALUES("
+    oss << "INSERT INTO measurements(sensor_id, epoch_ms, iso, value) VALUES(" << s.sensor << ','
         << std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count()
-        << ",'" << iso_time(s.ts) << "'," << s.value << ");";
+        << ",'" << iso << "'," << s.value << ");";
     return exec(oss.str(), err);
 }
 
-bool Database::insert_hourly(const Sample& s, std::string& err) {
-    std::ostringstream oss;
-    oss << "INSERT INTO hourly_avg(epoch_ms, iso, value) VALUES("
-        << std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count()
-        << ",'" << iso_time(s.ts) << "'," << s.value << ");";
-    return exec(oss.str(), err);
+bool Database::insert_measurements(const Sample* samples, std::size_t n, std::string& err) {
+    if (n == 0) return true;
+    const char* sql = "INSERT INTO measurements(sensor_id, epoch_ms, iso, value) VALUES(?, ?, ?, ?)";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    if (!exec("BEGIN IMMEDIATE;", err)) {
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    char iso[kIsoTimeLen + 1];
+    for (std::size_t i = 0; i < n; ++i) {
+        const Sample& s = samples[i];
+        format_iso_time(s.ts, iso);
+        sqlite3_bind_int64(stmt, 1, s.sensor);
+        sqlite3_bind_int64(stmt, 2, std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count());
+        sqlite3_bind_text(stmt, 3, iso, static_cast<int>(kIsoTimeLen), SQLITE_TRANSIENT);
+        sqlite3_bind_double(stmt, 4, s.value);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            err = sqlite3_errmsg(db_);
+            std::string ignored;
+            exec("ROLLBACK;", ignored);
+            sqlite3_finalize(stmt);
+            return false;
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return exec("COMMIT;", err);
 }
 
-bool Database::insert_daily(const Sample& s, std::string& err) {
+bool Database::insert_rollup(const std::string& table, const Sample& s, std::string& err) {
+    char iso[kIsoTimeLen + 1];
+    format_iso_time(s.ts, iso);
     std::ostringstream oss;
-    oss << "INSERT INTO daily_avg(epoch_ms, iso, value) VALUES("
+    oss.precision(std::numeric_limits<double>::max_digits10);  // same value as the bound double in insert_rollups
+    oss << "INSERT OR REPLACE INTO " << table << "(sensor_id, epoch_ms, iso, value) VALUES(" << s.sensor << ','
         << std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count()
-        << ",'" << iso_time(s.ts) << "'," << s.value << ");";
+        << ",'" << iso << "'," << s.value << ");";
     return exec(oss.str(), err);
 }
 
-std::optional<Sample> Database::latest_measurement(std::string& err) {
-    const char* sql = "SELECT epoch_ms, value FROM measurements ORDER BY epoch_ms DESC LIMIT 1";
+bool Database::insert_rollups(const std::vector<RollupRow>& rows, std::string& err) {
+    if (rows.empty()) return true;
+    std::array<sqlite3_stmt*, kRollupLevelCount> stmts{};
+    auto finalize_all = [&]() {
+        for (auto* stmt : stmts) {
+            if (stmt) sqlite3_finalize(stmt);
+        }
+    };
+    for (std::size_t i = 0; i < kRollupLevelCount; ++i) {
+        std::ostringstream oss;
+        oss << "INSERT OR REPLACE INTO " << kRollupLevels[i].table << "(sensor_id, epoch_ms, iso, value) VALUES(?, ?, ?, ?)";
+        if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmts[i], nullptr) != SQLITE_OK) {
+            err = sqlite3_errmsg(db_);
+            finalize_all();
+            return false;
+        }
+    }
+    if (!exec("BEGIN IMMEDIATE;", err)) {
+        finalize_all();
+        return false;
+    }
+    char iso[kIsoTimeLen + 1];
+    for (const auto& row : rows) {
+        sqlite3_stmt* stmt = stmts[row.level];
+        format_iso_time(TimePoint(std::chrono::milliseconds(row.start_ms)), iso);
+        sqlite3_bind_int64(stmt, 1, row.sensor);
+        sqlite3_bind_int64(stmt, 2, row.start_ms);
+        sqlite3_bind_text(stmt, 3, iso, static_cast<int>(kIsoTimeLen), SQLITE_TRANSIENT);
+        sqlite3_bind_double(stmt, 4, row.acc.avg());
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            err = sqlite3_errmsg(db_);
+            std::string ignored;
+            exec("ROLLBACK;", ignored);
+            finalize_all();
+            return false;
+        }
+        sqlite3_reset(stmt);
+    }
+    finalize_all();
+    return exec("COMMIT;", err);
+}
+
+std::optional<Sample> Database::latest_measurement(SensorId sensor, std::string& err) {
+    std::ostringstream oss;
+    oss << "SELECT epoch_ms, value FROM measurements WHERE sensor_id = " << sensor << " ORDER BY epoch_ms DESC LIMIT 1";
     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         err = sqlite3_errmsg(db_);
         return std::nullopt;
     }
@@ -72,15 +240,18 @@ std::optional<Sample> Database::latest_measurement(std::string& err) {
     if (sqlite3_step(stmt) == SQLITE_ROW) {
         std::int64_t ms = sqlite3_column_int64(stmt, 0);
         double v = sqlite3_column_double(stmt, 1);
-        res = Sample{TimePoint(std::chrono::milliseconds(ms)), v};
+        res = Sample{TimePoint(std::chrono::milliseconds(ms)), v, sensor};
     }
     sqlite3_finalize(stmt);
     return res;
 }
 
-bool Database::query_range(const std::string& table, std::int64_t start_ms, std::int64_t end_ms, std::vector<Sample>& out, std::string& err) {
+bool Database::query_range(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms, std::vector<Sample>& out,
+                           std::string& err, std::size_t limit) {
     std::ostringstream oss;
-    oss << "SELECT epoch_ms, value FROM " << table << " WHERE epoch_ms BETWEEN " << start_ms << " AND " << end_ms << " ORDER BY epoch_ms";
+    oss << "SELECT epoch_ms, value FROM " << table << " WHERE sensor_id = " << sensor << " AND epoch_ms BETWEEN " << start_ms
+        << " AND " << end_ms << " ORDER BY epoch_ms";
+    if (limit > 0) oss << " LIMIT " << limit;
     sqlite3_stmt* stmt = nullptr;
     if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
         err = sqlite3_errmsg(db_);
@@ -89,26 +260,96 @@ bool Database::query_range(const std::string& table, std::int64_t start_ms, std:
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         std::int64_t ms = sqlite3_column_int64(stmt, 0);
         double v = sqlite3_column_double(stmt, 1);
-        out.push_back(Sample{TimePoint(std::chrono::milliseconds(ms)), v});
+        out.push_back(Sample{TimePoint(std::chrono::milliseconds(ms)), v, sensor});
     }
     sqlite3_finalize(stmt);
     return true;
 }
 
+bool Database::query_columns(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms,
+                             std::vector<std::int64_t>& ts, std::vector<double>& values, std::string& err) {
+    std::ostringstream oss;
+    oss << "SELECT epoch_ms, value FROM " << table << " WHERE sensor_id = " << sensor << " AND epoch_ms BETWEEN " << start_ms
+        << " AND " << end_ms << " ORDER BY epoch_ms";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ts.push_back(sqlite3_column_int64(stmt, 0));
+        values.push_back(sqlite3_column_double(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::time_bounds(const std::string& table, std::int64_t& first_ms, std::int64_t& last_ms, std::string& err) {
+    std::ostringstream oss;
+    oss << "SELECT MIN(epoch_ms), MAX(epoch_ms) FROM " << table;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        first_ms = sqlite3_column_int64(stmt, 0);
+        last_ms = sqlite3_column_int64(stmt, 1);
+        found = true;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool Database::sum_range(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms, Accum& acc,
+                         std::string& err) {
+    std::ostringstream oss;
+    oss << "SELECT COUNT(*), TOTAL(value) FROM " << table << " WHERE sensor_id = " << sensor << " AND epoch_ms >= " << start_ms
+        << " AND epoch_ms < " << end_ms;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return false;
+    }
+    acc.reset();
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        acc.count = static_cast<std::size_t>(sqlite3_column_int64(stmt, 0));
+        acc.sum = sqlite3_column_double(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+std::size_t Database::count_range(const std::string& table, SensorId sensor, std::int64_t start_ms, std::int64_t end_ms, std::string& err) {
+    std::ostringstream oss;
+    oss << "SELECT COUNT(*) FROM " << table << " WHERE sensor_id = " << sensor << " AND epoch_ms BETWEEN " << start_ms << " AND "
+        << end_ms;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, oss.str().c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        err = sqlite3_errmsg(db_);
+        return 0;
+    }
+    std::size_t n = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) n = static_cast<std::size_t>(sqlite3_column_int64(stmt, 0));
+    sqlite3_finalize(stmt);
+    return n;
+}
+
 bool Database::prune_measurements(std::int64_t cutoff_ms, std::string& err) {
     std::ostringstream oss;
     oss << "DELETE FROM measurements WHERE epoch_ms < " << cutoff_ms;
     return exec(oss.str(), err);
 }
 
-bool Database::prune_hourly(std::int64_t cutoff_ms, std::string& err) {
+bool Database::prune_rollup(const std::string& table, std::int64_t cutoff_ms, std::string& err) {
     std::ostringstream oss;
-    oss << "DELETE FROM hourly_avg WHERE epoch_ms < " << cutoff_ms;
+    oss << "DELETE FROM " << table << " WHERE epoch_ms < " << cutoff_ms;
     return exec(oss.str(), err);
 }
 
-bool Database::prune_daily_current_year(std::string& err) {
-    const auto now = Clock::now();
+bool Database::prune_daily_current_year(std::int64_t now_ms, std::string& err) {
+    const TimePoint now{std::chrono::milliseconds(now_ms)};
     auto tt = Clock::to_time_t(now);
     std::tm tm{};
 #ifdef _WIN32
@@ -1,6 +1,7 @@
 ﻿#include "http_server.h"
 
 #include <cstring>
+#include <exception>
 #include <sstream>
 
 #ifdef _WIN32
@@ -29,7 +30,7 @@ static std::string make_response(const std::string& body, const std::string& sta
     return oss.str();
 }
 
-bool HttpServer::start(int port, std::function<std::pair<std::string, std::string>(const std::string&)> handler, std::string& err) {
+bool HttpServer::start(int port, std::function<HttpResponse(const std::string&)> handler, std::string& err) {
     handler_ = std::move(handler);
     running_ = true;
 #ifdef _WIN32
@@ -52,6 +53,8 @@ void HttpServer::stop() {
     }
 #else
     if (listen_fd_ >= 0) {
+        // close() alone does not wake a thread blocked in accept() on Linux.
+        shutdown(static_cast<int>(listen_fd_), SHUT_RDWR);
         close(listen_fd_);
         listen_fd_ = -1;
     }
@@ -103,14 +106,16 @@ void HttpServer::run(int port) {
         if (n > 0) {
             buf[n] = '\0';
             std::string req(buf);
-            std::string body = "{}";
-            std::string content_type = "application/json";
+            HttpResponse res{"{}"};
             if (handler_) {
-                auto res = handler_(req);
-                body = res.first;
-                content_type = res.second.empty() ? content_type : res.second;
+                try {
+                    res = handler_(req);
+                } catch (const std::exception&) {
+                    res = HttpResponse{"{\"error\":\"internal error\"}", "application/json", "500 Internal Server Error"};
+                }
+                if (res.content_type.empty()) res.content_type = "application/json";
             }
-            auto resp = make_response(body, "200 OK", content_type);
+            auto resp = make_response(res.body, res.status, res.content_type);
             send(client, resp.c_str(), static_cast<int>(resp.size()), 0);
         }
 #ifdef _WIN32
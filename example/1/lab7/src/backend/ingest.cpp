@@ -0,0 +1,221 @@
+#include "ingest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace lab5 {
+
+namespace {
+constexpr std::size_t kBatchSize = 1024;
+
+// How often rollup rows that missed late samples are recomputed.
+constexpr std::int64_t kDirtyFlushIntervalMs = 1000;
+
+void pin_to_cpu(std::thread& t, int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t;
+    (void)cpu;
+#endif
+}
+}  // namespace
+
+std::size_t shard_for(SensorId sensor, std::size_t shards) {
+    return static_cast<std::size_t>(((static_cast<std::uint64_t>(sensor) * 0x9E3779B97F4A7C15ULL) >> 32) % shards);
+}
+
+IngestShard::IngestShard(std::size_t index, IngestConfig config)
+    : index_(index), config_(std::move(config)), queue_(config_.queue_capacity) {}
+
+IngestShard::~IngestShard() { stop(); }
+
+bool IngestShard::open(const std::string& db_path, std::string& err) {
+    return !config_.store || db_.open(db_path, err);
+}
+
+void IngestShard::restore(SensorAggregates&& state) {
+    auto& st = state_of(state.sensor);
+    st.rollups = std::move(state.rollups);
+    st.windows = std::move(state.windows);
+    st.last_ordered_ms = state.applied_ms;
+}
+
+void IngestShard::replay(SensorId sensor, const std::vector<Sample>& rows) {
+    std::lock_guard<std::mutex> lk(state_mu_);
+    {
+        std::lock_guard<std::mutex> views(current_mu_);
+        SensorState& st = state_of(sensor);
+        CurrentView& view = view_of(sensor);
+        for (const auto& s : rows) {
+            if (!view.latest || s.ts >= view.latest->ts) view.latest = s;
+            aggregate(st, s, view);
+        }
+    }
+    write_closed();
+}
+
+void IngestShard::start(int cpu) {
+    last_dirty_flush_ms_ = now_ms();
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+    if (cpu >= 0) pin_to_cpu(thread_, cpu);
+}
+
+void IngestShard::push(const Sample& s) {
+    while (!queue_.try_push(s)) std::this_thread::yield();
+}
+
+void IngestShard::push_batch(const Sample* samples, std::size_t n) {
+    while (true) {
+        const std::size_t pushed = queue_.try_push_batch(samples, n);
+        samples += pushed;
+        n -= pushed;
+        if (n == 0) return;
+        std::this_thread::yield();
+    }
+}
+
+void IngestShard::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+void IngestShard::run() {
+    std::vector<Sample> batch(kBatchSize);
+    unsigned idle = 0;
+    while (true) {
+        const std::size_t n = queue_.pop_batch(batch.data(), batch.size());
+        if (n != 0) {
+            idle = 0;
+            std::lock_guard<std::mutex> lk(state_mu_);
+            process_batch(batch.data(), n);
+            continue;
+        }
+        if (!running_.load()) {
+            if (queue_.empty()) break;
+            continue;
+        }
+        // Spin briefly for bursts, then back off so idle shards cost nothing.
+        if (++idle < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (!dirty_.empty() && now_ms() - last_dirty_flush_ms_ >= kDirtyFlushIntervalMs) {
+                std::lock_guard<std::mutex> lk(state_mu_);
+                flush_dirty();
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(state_mu_);
+    {
+        std::lock_guard<std::mutex> views(current_mu_);
+        states_.for_each([&](SensorId sensor, SensorState& st) {
+            st.reorder.drain(ordered_);
+            for (const auto& o : ordered_) aggregate(st, o, view_of(sensor));
+            ordered_.clear();
+        });
+    }
+    write_closed();
+    flush_dirty();
+}
+
+void IngestShard::process_batch(const Sample* batch, std::size_t n) {
+    // Raw rows go in first so that dirty buckets can be recomputed from them.
+    if (config_.store && !db_.insert_measurements(batch, n, err_)) {
+        std::cerr << "Shard " << index_ << ": raw insert failed: " << err_ << "\n";
+    }
+    {
+        std::lock_guard<std::mutex> views(current_mu_);
+        for (std::size_t i = 0; i < n; ++i) {
+            const Sample& s = batch[i];
+            SensorState& st = state_of(s.sensor);
+            CurrentView& view = view_of(s.sensor);
+            if (!view.latest || s.ts >= view.latest->ts) view.latest = s;
+            st.reorder.push(s, ordered_);
+            for (const auto& o : ordered_) aggregate(st, o, view);
+            ordered_.clear();
+        }
+    }
+    write_closed();
+    if (!dirty_.empty() && now_ms() - last_dirty_flush_ms_ >= kDirtyFlushIntervalMs) flush_dirty();
+    processed_.fetch_add(n, std::memory_order_relaxed);
+}
+
+void IngestShard::aggregate(SensorState& st, const Sample& s, CurrentView& view) {
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count();
+    data_now_ms_ = std::max<std::int64_t>(data_now_ms_, ms);
+    const std::uint32_t missed = st.rollups.add(ms, s.value, closed_);
+    for (std::size_t level = 0; missed != 0 && level < kRollupLevelCount; ++level) {
+        if (missed & (1u << level)) dirty_.emplace(s.sensor, level, bucket_start(ms, kRollupLevels[level].period_ms));
+    }
+    if (ms < st.last_ordered_ms) return;
+    st.last_ordered_ms = ms;
+    st.windows.add(ms, s.value);
+    st.windows.snapshot(view.windows);
+}
+
+void IngestShard::write_closed() {
+    if (config_.store && !closed_.empty() && !db_.insert_rollups(closed_, err_)) {
+        std::cerr << "Shard " << index_ << ": rollup write failed: " << err_ << "\n";
+    }
+    closed_.clear();
+}
+
+void IngestShard::flush_dirty() {
+    // Buckets entirely older than raw retention keep their stored value; one that
+    // straddles the raw floor is recomputed from the part raw data still covers.
+    const std::int64_t raw_floor = data_now_ms_ - kRawRetentionMs;
+    for (const auto& [sensor, level, start] : dirty_) {
+        const auto& lvl = kRollupLevels[level];
+        const std::int64_t end = bucket_end(start, lvl.period_ms);
+        if (!config_.store || end <= raw_floor) continue;
+        Accum acc;
+        if (db_.sum_range("measurements", sensor, std::max(start, raw_floor), end, acc, err_) && acc.count != 0) {
+            db_.insert_rollup(lvl.table, Sample{TimePoint(std::chrono::milliseconds(start)), acc.avg(), sensor}, err_);
+        }
+    }
+    dirty_.clear();
+    last_dirty_flush_ms_ = now_ms();
+}
+
+void IngestShard::flush_open() {
+    std::lock_guard<std::mutex> lk(state_mu_);
+    states_.for_each([&](SensorId, SensorState& st) { st.rollups.flush(closed_); });
+    write_closed();
+}
+
+void IngestShard::snapshot(std::vector<SensorAggregates>& out) {
+    std::lock_guard<std::mutex> lk(state_mu_);
+    states_.for_each([&](SensorId sensor, const SensorState& st) {
+        out.push_back({sensor, st.last_ordered_ms, st.rollups, st.windows});
+    });
+}
+
+std::optional<CurrentView> IngestShard::current(SensorId sensor) const {
+    std::lock_guard<std::mutex> lk(current_mu_);
+    if (const auto* view = current_.find(sensor)) return *view;
+    return std::nullopt;
+}
+
+IngestShard::SensorState& IngestShard::state_of(SensorId sensor) {
+    if (auto* st = states_.find(sensor)) return *st;
+    return states_.insert(sensor, SensorState{RollupCascade(sensor), WindowSet(config_.windows), ReorderBuffer(config_.reorder_delay_ms)});
+}
+
+CurrentView& IngestShard::view_of(SensorId sensor) {
+    if (auto* view = current_.find(sensor)) return *view;
+    return current_.insert(sensor, CurrentView{});
+}
+
+}  // namespace lab5
@@ -1,8 +1,9 @@
 ﻿#include "logging.h"
 #include "common.h"
 
+#include <algorithm>
 #include <chrono>
-#include <iomanip>
+#include <cstdio>
 #include <optional>
 #include <sstream>
 
@@ -10,9 +11,12 @@ namespace lab5 {
 
 std::string format_line(const Sample& s) {
     auto ms_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count();
-    std::ostringstream oss;
-    oss << ms_epoch << ';' << iso_time(s.ts) << ';' << std::fixed << std::setprecision(2) << s.value;
-    return oss.str();
+    char iso[kIsoTimeLen + 1];
+    format_iso_time(s.ts, iso);
+    char buf[128];
+    int n = std::snprintf(buf, sizeof(buf), "%lld;%s;%.2f", static_cast<long long>(ms_epoch), iso, s.value);
+    if (n < 0) return {};
+    return std::string(buf, std::min<std::size_t>(static_cast<std::size_t>(n), sizeof(buf) - 1));
 }
 
 std::optional<std::int64_t> parse_epoch_ms(const std::string& line) {
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "aggregate.h"
+#include "common.h"
+#include "rebuild.h"
+#include "replay.h"
+#include "simulator.h"
+
+namespace lab5 {
+int run_main(bool simulate, const SimulatorConfig& sim_config, const ReplayConfig& replay_config, bool bulk_stdin);
+}  // namespace lab5
+
+namespace {
+int rebuild(unsigned threads) {
+    lab5::RebuildStats stats;
+    std::string err;
+    const bool ok = lab5::rebuild_rollups(lab5::db_path(), threads, stats, err);
+    std::cout << "Rebuilt " << stats.rollup_rows << " rollup rows from " << stats.raw_rows << " raw rows in " << stats.partitions
+              << " day partitions (" << stats.skipped_rows << " buckets skipped), " << stats.seconds << " s";
+    if (stats.seconds > 0) std::cout << ", " << static_cast<long long>(stats.raw_rows / stats.seconds) << " raw rows/s";
+    std::cout << "\n";
+    if (!ok) {
+        std::cerr << "Rebuild failed: " << err << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Local midnight (or time) of "YYYY-MM-DD" / "YYYY-MM-DDTHH:MM:SS" in epoch ms.
+std::optional<std::int64_t> parse_date(const std::string& text) {
+    std::tm tm{};
+    std::istringstream iss(text);
+    iss >> std::get_time(&tm, text.size() > 10 ? "%Y-%m-%dT%H:%M:%S" : "%Y-%m-%d");
+    if (iss.fail()) return std::nullopt;
+    tm.tm_isdst = -1;
+    return static_cast<std::int64_t>(std::mktime(&tm)) * 1000;
+}
+
+std::optional<lab5::Overflow> parse_overflow(const std::string& text) {
+    if (text == "block") return lab5::Overflow::kBlock;
+    if (text == "drop-newest") return lab5::Overflow::kDropNewest;
+    if (text == "drop-oldest") return lab5::Overflow::kDropOldest;
+    return std::nullopt;
+}
+
+// "path" or "path=sensor".
+lab5::ReplayFile parse_replay_file(const std::string& text) {
+    const auto eq = text.rfind('=');
+    if (eq == std::string::npos) return {text, ""};
+    return {text.substr(0, eq), text.substr(eq + 1)};
+}
+
+int usage() {
+    std::cerr << "usage: lab7_server [--simulate [--sensors N] [--seed N] [--fast] [--start YYYY-MM-DD]\n"
+                 "                   [--rate HZ] [--duration 30d] [--queue N]\n"
+                 "                   [--overflow block|drop-newest|drop-oldest] [--threads N]]\n"
+                 "       lab7_server --bulk < samples.txt\n"
+                 "       lab7_server --replay LOG[=SENSOR] [--replay ...] [--speed N|max]\n"
+                 "       lab7_server --rebuild-rollups [--threads N]\n";
+    return 2;
+}
+}  // namespace
+
+// Headless backend: the same server as the GUI embeds, plus maintenance modes.
+// --fast runs the simulator on a virtual clock from --start for --duration,
+// e.g. a year of 10 sensors at 1 Hz: --simulate --fast --seed 1 --sensors 10
+// --rate 1 --start 2025-01-01 --duration 365d. --threads sets the simulator's
+// worker count as well as the rebuild's. --replay plays back lab4/4lab logs
+// with their original timestamps, in real time or --speed times faster.
+// --bulk loads "epoch_ms value" or "value" lines from stdin in large blocks and
+// exits at end of input.
+int main(int argc, char* argv[]) {
+    bool simulate = false;
+    bool rebuild_mode = false;
+    bool bulk = false;
+    unsigned threads = 0;
+    lab5::SimulatorConfig sim;
+    lab5::ReplayConfig replay;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--simulate") simulate = true;
+        else if (arg == "--rebuild-rollups") rebuild_mode = true;
+        else if (arg == "--bulk") bulk = true;
+        else if (arg == "--fast") sim.fast_forward = true;
+        else if (arg == "--threads" && has_value) threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--sensors" && has_value) sim.sensors = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && has_value) sim.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--replay" && has_value) replay.files.push_back(parse_replay_file(argv[++i]));
+        else if (arg == "--speed" && has_value) {
+            const std::string speed = argv[++i];
+            replay.speed = speed == "max" ? 0.0 : std::strtod(speed.c_str(), nullptr);
+            if (!(replay.speed >= 0)) return usage();
+        } else if (arg == "--queue" && has_value) sim.queue_capacity = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--overflow" && has_value) {
+            auto overflow = parse_overflow(argv[++i]);
+            if (!overflow) return usage();
+            sim.overflow = *overflow;
+        } else if (arg == "--rate" && has_value) {
+            const double hz = std::strtod(argv[++i], nullptr);
+            if (!(hz > 0)) return usage();
+            sim.step_ms = std::max<std::int64_t>(1, std::llround(1000.0 / hz));
+        } else if (arg == "--start" && has_value) {
+            auto ms = parse_date(argv[++i]);
+            if (!ms) return usage();
+            sim.start_ms = *ms;
+        } else if (arg == "--duration" && has_value) {
+            auto ms = lab5::parse_step(argv[++i]);
+            if (!ms) return usage();
+            sim.duration_ms = *ms;
+        } else {
+            return usage();
+        }
+    }
+    if (rebuild_mode) return rebuild(threads);
+    sim.threads = threads;
+    return lab5::run_main(simulate, sim, replay, bulk);
+}
@@ -0,0 +1,159 @@
+#include "rebuild.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "db.h"
+#include "rollup.h"
+
+namespace lab5 {
+
+namespace {
+// Rows per write transaction: large enough to amortize the commit, small enough
+// that ingest never waits long for the write lock.
+constexpr std::size_t kBatchRows = 20000;
+
+struct PartitionResult {
+    std::size_t raw_rows = 0;
+    std::size_t skipped_rows = 0;
+    std::vector<RollupRow> rows;
+    std::string err;
+};
+}  // namespace
+
+bool rebuild_rollups(const std::string& db_path, unsigned threads, RebuildStats& stats, std::string& err) {
+    const auto t0 = std::chrono::steady_clock::now();
+    stats = RebuildStats{};
+
+    Database writer;
+    if (!writer.open(db_path, err)) return false;
+    std::int64_t first_ms = 0;
+    std::int64_t last_ms = 0;
+    if (!writer.time_bounds("measurements", first_ms, last_ms, err)) {
+        if (err.empty()) err = "no raw measurements";
+        return false;
+    }
+
+    std::vector<std::pair<SensorId, std::string>> sensors;
+    if (!writer.load_sensors(sensors, err)) return false;
+
+    std::vector<std::int64_t> days;
+    for (std::int64_t day = bucket_start(first_ms, kDayMs); day <= last_ms; day = bucket_end(day, kDayMs)) {
+        days.push_back(day);
+    }
+    stats.partitions = days.size();
+
+    // Buckets that started before the oldest raw sample lost part of their input to
+    // raw retention; rewriting them would replace good values with partial ones.
+    const std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now().time_since_epoch()).count();
+    auto keep = [&](const RollupRow& row) {
+        if (row.start_ms < first_ms) return false;
+        const auto retention = kRollupLevels[row.level].retention_ms;
+        return retention == 0 || row.start_ms >= now - retention;
+    };
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, days.size()));
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<PartitionResult> ready;
+    std::size_t finished_workers = 0;
+
+    auto worker = [&]() {
+        Database db;
+        std::string werr;
+        const bool opened = db.open(db_path, werr);
+        std::vector<std::int64_t> ts;
+        std::vector<double> values;
+        while (opened && !failed.load()) {
+            const std::size_t i = next.fetch_add(1);
+            if (i >= days.size()) break;
+            const std::int64_t day_end = bucket_end(days[i], kDayMs);
+            PartitionResult res;
+            for (const auto& sensor : sensors) {
+                ts.clear();
+                values.clear();
+                if (!db.query_columns("measurements", sensor.first, days[i], day_end - 1, ts, values, res.err)) {
+                    failed = true;
+                    break;
+                }
+                RollupCascade cascade(sensor.first);
+                for (std::size_t k = 0; k < ts.size(); ++k) cascade.add(ts[k], values[k], res.rows);
+                cascade.flush(res.rows);
+                res.raw_rows += ts.size();
+            }
+            const std::size_t total = res.rows.size();
+            res.rows.erase(std::remove_if(res.rows.begin(), res.rows.end(), [&](const RollupRow& r) { return !keep(r); }),
+                           res.rows.end());
+            res.skipped_rows = total - res.rows.size();
+            std::lock_guard<std::mutex> lock(mu);
+            ready.push_back(std::move(res));
+            cv.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        if (!opened) {
+            failed = true;
+            PartitionResult res;
+            res.err = werr;
+            ready.push_back(std::move(res));
+        }
+        ++finished_workers;
+        cv.notify_one();
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; ++i) pool.emplace_back(worker);
+
+    std::vector<RollupRow> batch;
+    bool ok = true;
+    auto write_batch = [&]() {
+        if (!ok || batch.empty()) {
+            batch.clear();
+            return;
+        }
+        if (writer.insert_rollups(batch, err)) {
+            stats.rollup_rows += batch.size();
+        } else {
+            ok = false;
+            failed = true;
+        }
+        batch.clear();
+    };
+
+    std::unique_lock<std::mutex> lock(mu);
+    while (true) {
+        cv.wait(lock, [&]() { return !ready.empty() || finished_workers == threads; });
+        if (ready.empty()) break;
+        PartitionResult res = std::move(ready.front());
+        ready.pop_front();
+        lock.unlock();
+
+        if (!res.err.empty()) {
+            if (ok) err = res.err;
+            ok = false;
+        } else {
+            stats.raw_rows += res.raw_rows;
+            stats.skipped_rows += res.skipped_rows;
+            batch.insert(batch.end(), res.rows.begin(), res.rows.end());
+            if (batch.size() >= kBatchRows) write_batch();
+        }
+        lock.lock();
+    }
+    lock.unlock();
+    write_batch();
+    for (auto& t : pool) t.join();
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return ok;
+}
+
+}  // namespace lab5
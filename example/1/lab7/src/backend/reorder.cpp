@@ -0,0 +1,41 @@
+#include "reorder.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace lab5 {
+
+namespace {
+std::int64_t epoch_ms_of(const Sample& s) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(s.ts.time_since_epoch()).count();
+}
+
+bool later(const Sample& a, const Sample& b) { return a.ts > b.ts; }
+}  // namespace
+
+void ReorderBuffer::push(const Sample& s, std::vector<Sample>& ready) {
+    const std::int64_t ms = epoch_ms_of(s);
+    if (delay_ms_ <= 0 || (seen_ && ms <= max_seen_ms_ - delay_ms_)) {
+        ready.push_back(s);
+        return;
+    }
+    max_seen_ms_ = seen_ ? std::max(max_seen_ms_, ms) : ms;
+    seen_ = true;
+    heap_.push_back(s);
+    std::push_heap(heap_.begin(), heap_.end(), later);
+
+    const std::int64_t watermark = max_seen_ms_ - delay_ms_;
+    while (!heap_.empty() && (epoch_ms_of(heap_.front()) <= watermark || heap_.size() > max_size_)) pop_oldest(ready);
+}
+
+void ReorderBuffer::drain(std::vector<Sample>& ready) {
+    while (!heap_.empty()) pop_oldest(ready);
+}
+
+void ReorderBuffer::pop_oldest(std::vector<Sample>& ready) {
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    ready.push_back(heap_.back());
+    heap_.pop_back();
+}
+
+}  // namespace lab5
@@ -0,0 +1,187 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std::chrono;
+
+namespace lab5 {
+
+namespace {
+
+// Longest sleep inside next_batch, so slow playback still notices shutdown.
+constexpr auto kMaxSleep = milliseconds(200);
+
+const char* skip_spaces(const char* p, const char* end) {
+    while (p != end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+}  // namespace
+
+bool parse_log_line(const char* begin, const char* end, std::int64_t& epoch_ms, double& value) {
+    if (end != begin && end[-1] == '\r') --end;
+    const char* p = skip_spaces(begin, end);
+    if (p == end) return false;
+
+    if (const auto* semi = static_cast<const char*>(std::memchr(p, ';', static_cast<std::size_t>(end - p)))) {
+        // lab4: epoch_ms;iso;value
+        auto r = std::from_chars(p, semi, epoch_ms);
+        if (r.ec != std::errc() || r.ptr != semi) return false;
+        const char* last = semi;
+        for (const char* q = semi + 1; q != end; ++q) {
+            if (*q == ';') last = q;
+        }
+        if (last == semi) return false;
+        const char* v = skip_spaces(last + 1, end);
+        r = std::from_chars(v, end, value);
+        return r.ec == std::errc() && skip_spaces(r.ptr, end) == end;
+    }
+
+    // 4lab: epoch_seconds value
+    std::int64_t seconds = 0;
+    auto r = std::from_chars(p, end, seconds);
+    if (r.ec != std::errc() || r.ptr == end || (*r.ptr != ' ' && *r.ptr != '\t')) return false;
+    const char* v = skip_spaces(r.ptr, end);
+    r = std::from_chars(v, end, value);
+    if (r.ec != std::errc() || skip_spaces(r.ptr, end) != end) return false;
+    epoch_ms = seconds * 1000;
+    return true;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+bool MappedFile::open(const std::string& path, std::string& err) {
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        err = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        err = "cannot stat " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        err = "cannot map " + path + ": " + std::strerror(errno);
+        size_ = 0;
+        return false;
+    }
+    madvise(p, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(p);
+    mapped_ = true;
+    return true;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        err = "cannot open " + path;
+        return false;
+    }
+    copy_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = copy_.data();
+    size_ = copy_.size();
+    return true;
+#endif
+}
+
+bool LogReplay::open(const ReplayConfig& config, const std::vector<SensorId>& sensors, std::string& err) {
+    speed_ = config.speed;
+    for (std::size_t i = 0; i < config.files.size(); ++i) {
+        auto c = std::make_unique<Cursor>();
+        if (!c->file.open(config.files[i].path, err)) return false;
+        c->pos = c->file.data();
+        c->end = c->file.data() + c->file.size();
+        c->sensor = i < sensors.size() ? sensors[i] : kDefaultSensor;
+        advance(*c);
+        cursors_.push_back(std::move(c));
+    }
+    return true;
+}
+
+void LogReplay::advance(Cursor& c) {
+    c.has_next = false;
+    while (c.pos != c.end) {
+        const auto* nl = static_cast<const char*>(std::memchr(c.pos, '\n', static_cast<std::size_t>(c.end - c.pos)));
+        const char* line_end = nl ? nl : c.end;
+        const char* line = c.pos;
+        c.pos = nl ? nl + 1 : c.end;
+        if (line == line_end || (line_end - line == 1 && *line == '\r')) continue;
+
+        ++lines_;
+        std::int64_t ms = 0;
+        double value = 0.0;
+        if (!parse_log_line(line, line_end, ms, value)) {
+            ++skipped_;
+            continue;
+        }
+        c.next = Sample{TimePoint(milliseconds(ms)), value, c.sensor};
+        c.has_next = true;
+        return;
+    }
+}
+
+LogReplay::Cursor* LogReplay::earliest() {
+    Cursor* best = nullptr;
+    for (auto& c : cursors_) {
+        if (c->has_next && (!best || c->next.ts < best->next.ts)) best = c.get();
+    }
+    return best;
+}
+
+bool LogReplay::finished() const {
+    return std::none_of(cursors_.begin(), cursors_.end(), [](const auto& c) { return c->has_next; });
+}
+
+std::size_t LogReplay::next_batch(Sample* out, std::size_t max) {
+    std::size_t n = 0;
+    while (n < max) {
+        Cursor* c = earliest();
+        if (!c) break;
+        const std::int64_t ms = duration_cast<milliseconds>(c->next.ts.time_since_epoch()).count();
+        if (!started_) {
+            started_ = true;
+            wall_origin_ = steady_clock::now();
+            data_origin_ms_ = ms;
+        }
+        if (speed_ > 0) {
+            const auto offset = duration<double, std::milli>(static_cast<double>(ms - data_origin_ms_) / speed_);
+            const auto due = wall_origin_ + duration_cast<steady_clock::duration>(offset);
+            const auto now = steady_clock::now();
+            if (due > now) {
+                if (n != 0) break;
+                std::this_thread::sleep_until(std::min(due, now + kMaxSleep));
+                if (due > steady_clock::now()) break;
+            }
+        }
+        out[n++] = c->next;
+        advance(*c);
+    }
+    return n;
+}
+
+}  // namespace lab5
@@ -0,0 +1,189 @@
+#include "rollup.h"
+
+#include <algorithm>
+#include <ctime>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+namespace lab5 {
+
+const std::array<RollupLevel, kRollupLevelCount> kRollupLevels = {{
+    {"1m", "rollup_1m", 60LL * 1000, 2 * kDayMs},
+    {"5m", "rollup_5m", 5LL * 60 * 1000, 7 * kDayMs},
+    {"15m", "rollup_15m", 15LL * 60 * 1000, 30 * kDayMs},
+    {"1h", "hourly_avg", 60LL * 60 * 1000, 30 * kDayMs},
+    {"1d", "daily_avg", kDayMs, 0},
+}};
+
+namespace {
+std::tm local_tm(std::int64_t epoch_ms) {
+    std::int64_t sec = epoch_ms / 1000;
+    if (epoch_ms % 1000 < 0) --sec;
+    auto tt = static_cast<std::time_t>(sec);
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &tt);
+#else
+    localtime_r(&tt, &tm);
+#endif
+    return tm;
+}
+
+std::int64_t to_epoch_ms(std::tm& tm) {
+    tm.tm_isdst = -1;
+    return static_cast<std::int64_t>(std::mktime(&tm)) * 1000;
+}
+}  // namespace
+
+const RollupLevel* find_rollup_level(const std::string& name) {
+    const std::string key = name == "hourly" ? "1h" : (name == "daily" ? "1d" : name);
+    for (const auto& level : kRollupLevels) {
+        if (key == level.name || key == level.table) return &level;
+    }
+    return nullptr;
+}
+
+std::int64_t bucket_start(std::int64_t epoch_ms, std::int64_t period_ms) {
+    std::tm tm = local_tm(epoch_ms);
+    if (period_ms >= kDayMs) {
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+    } else {
+        const int period_s = static_cast<int>(period_ms / 1000);
+        int sod = tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+        sod -= sod % period_s;
+        tm.tm_hour = sod / 3600;
+        tm.tm_min = sod / 60 % 60;
+        tm.tm_sec = sod % 60;
+    }
+    return to_epoch_ms(tm);
+}
+
+std::int64_t bucket_end(std::int64_t start_ms, std::int64_t period_ms) {
+    if (period_ms < kDayMs) return start_ms + period_ms;
+    std::tm tm = local_tm(start_ms);
+    tm.tm_mday += 1;
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    return to_epoch_ms(tm);
+}
+
+namespace {
+// Oldest timestamp still kept by a tier (tier == -1 -> raw).
+std::int64_t tier_cutoff(int tier, std::int64_t now_ms) {
+    if (tier < 0) return now_ms - kRawRetentionMs;
+    const auto retention = kRollupLevels[static_cast<std::size_t>(tier)].retention_ms;
+    return retention > 0 ? now_ms - retention : std::numeric_limits<std::int64_t>::min();
+}
+
+std::vector<TierSegment> segments_from(int tier, std::int64_t start_ms, std::int64_t end_ms, std::int64_t now_ms) {
+    std::vector<TierSegment> segs;
+    std::int64_t seg_end = end_ms;
+    for (int t = tier; t < static_cast<int>(kRollupLevelCount) && seg_end >= start_ms; ++t) {
+        const bool last = t + 1 == static_cast<int>(kRollupLevelCount);
+        const std::int64_t seg_start = last ? start_ms : std::max(start_ms, tier_cutoff(t, now_ms));
+        if (seg_start > seg_end) continue;
+        segs.push_back({t < 0 ? nullptr : &kRollupLevels[static_cast<std::size_t>(t)], seg_start, seg_end});
+        seg_end = seg_start - 1;
+    }
+    std::reverse(segs.begin(), segs.end());
+    return segs;
+}
+}  // namespace
+
+std::vector<TierSegment> plan_tiers(std::int64_t start_ms, std::int64_t end_ms, std::size_t max_points, std::int64_t now_ms,
+                                    const std::function<std::size_t(std::int64_t, std::int64_t)>& count_raw) {
+    if (end_ms < start_ms) return {};
+    for (int tier = -1; tier + 1 < static_cast<int>(kRollupLevelCount); ++tier) {
+        auto segs = segments_from(tier, start_ms, end_ms, now_ms);
+        std::size_t points = 0;
+        for (const auto& seg : segs) {
+            if (seg.level) {
+                points += static_cast<std::size_t>((seg.end_ms - seg.start_ms) / seg.level->period_ms + 1);
+            } else {
+                points += count_raw(seg.start_ms, seg.end_ms);
+            }
+        }
+        if (points <= max_points) return segs;
+    }
+    return segments_from(static_cast<int>(kRollupLevelCount) - 1, start_ms, end_ms, now_ms);
+}
+
+std::uint32_t RollupCascade::add(std::int64_t epoch_ms, double value, std::vector<RollupRow>& closed) {
+    Accum one;
+    one.add(value);
+    if (open_[0].acc.count == 0 || epoch_ms >= open_[0].start_ms) {
+        feed(0, epoch_ms, one, closed);
+        return 0;
+    }
+    // Each closed bucket has already been folded into the next level, so the
+    // sample goes to every level up to the first open bucket that covers it.
+    std::uint32_t missed = 0;
+    for (std::size_t level = 0; level < kRollupLevelCount; ++level) {
+        auto& open = open_[level];
+        if (open.acc.count != 0 && epoch_ms >= open.start_ms && epoch_ms < open.end_ms) {
+            open.acc.merge(one);
+            break;
+        }
+        auto& last = last_closed_[level];
+        if (last.acc.count != 0 && epoch_ms >= last.start_ms && epoch_ms < last.end_ms) {
+            last.acc.merge(one);
+            closed.push_back(RollupRow{level, sensor_, last.start_ms, last.acc});
+        } else {
+            missed |= 1u << level;
+        }
+    }
+    return missed;
+}
+
+void RollupCascade::feed(std::size_t level, std::int64_t epoch_ms, const Accum& acc, std::vector<RollupRow>& closed) {
+    auto& open = open_[level];
+    if (open.acc.count != 0 && epoch_ms >= open.end_ms) {
+        const RollupRow row{level, sensor_, open.start_ms, open.acc};
+        last_closed_[level] = open;
+        open.acc.reset();
+        closed.push_back(row);
+        if (level + 1 < kRollupLevelCount) feed(level + 1, row.start_ms, row.acc, closed);
+    }
+    if (open.acc.count == 0) {
+        const auto period = kRollupLevels[level].period_ms;
+        open.start_ms = bucket_start(epoch_ms, period);
+        open.end_ms = bucket_end(open.start_ms, period);
+    }
+    open.acc.merge(acc);
+}
+
+void RollupCascade::flush(std::vector<RollupRow>& closed) {
+    for (std::size_t level = 0; level < kRollupLevelCount; ++level) {
+        auto& open = open_[level];
+        if (open.acc.count == 0) continue;
+        const RollupRow row{level, sensor_, open.start_ms, open.acc};
+        open.acc.reset();
+        closed.push_back(row);
+        if (level + 1 < kRollupLevelCount) feed(level + 1, row.start_ms, row.acc, closed);
+    }
+}
+
+void RollupCascade::save(std::ostream& out) const {
+    out << "levels " << kRollupLevelCount << '\n';
+    for (const auto& open : open_) {
+        out << open.start_ms << ' ' << open.end_ms << ' ' << open.acc.count << ' ' << open.acc.sum << '\n';
+    }
+}
+
+bool RollupCascade::load(std::istream& in) {
+    std::string tag;
+    std::size_t levels = 0;
+    if (!(in >> tag >> levels) || tag != "levels" || levels != kRollupLevelCount) return false;
+    std::array<OpenBucket, kRollupLevelCount> loaded{};
+    for (auto& open : loaded) {
+        if (!(in >> open.start_ms >> open.end_ms >> open.acc.count >> open.acc.sum)) return false;
+    }
+    open_ = loaded;
+    return true;
+}
+
+}  // namespace lab5
@@ -0,0 +1,54 @@
+#include "sensors.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "db.h"
+
+namespace lab5 {
+
+bool SensorRegistry::load(Database& db, std::string& err) {
+    std::vector<std::pair<SensorId, std::string>> rows;
+    if (!db.load_sensors(rows, err)) return false;
+    std::lock_guard<std::mutex> lk(mu_);
+    ids_.clear();
+    sensors_ = rows;
+    next_id_ = kDefaultSensor + 1;
+    for (const auto& [id, name] : rows) {
+        ids_[name] = id;
+        next_id_ = std::max(next_id_, id + 1);
+    }
+    return true;
+}
+
+std::optional<SensorId> SensorRegistry::intern(Database& db, const std::string& name, std::string& err) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    const SensorId id = next_id_;
+    if (!db.insert_sensor(id, name, err)) return std::nullopt;
+    ++next_id_;
+    ids_.emplace(name, id);
+    sensors_.emplace_back(id, name);
+    return id;
+}
+
+std::optional<SensorId> SensorRegistry::find(const std::string& name_or_id) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = ids_.find(name_or_id);
+    if (it != ids_.end()) return it->second;
+    char* end = nullptr;
+    const unsigned long id = std::strtoul(name_or_id.c_str(), &end, 10);
+    if (name_or_id.empty() || *end != '\0') return std::nullopt;
+    for (const auto& sensor : sensors_) {
+        if (sensor.first == id) return sensor.first;
+    }
+    return std::nullopt;
+}
+
+std::vector<std::pair<SensorId, std::string>> SensorRegistry::list() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return sensors_;
+}
+
+}  // namespace lab5
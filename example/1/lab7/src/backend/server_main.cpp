@@ -1,20 +1,35 @@
-﻿#include <atomic>
+﻿#include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <chrono>
 #include <csignal>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "aggregate.h"
+#include "bulk_input.h"
+#include "checkpoint.h"
 #include "common.h"
 #include "db.h"
+#include "ingest.h"
 #include "logging.h"
+#include "replay.h"
+#include "rollup.h"
 #include "sample.h"
+#include "sensors.h"
 #include "simulator.h"
+#include "window_stats.h"
 #include "http_server.h"
 
 using namespace std::chrono;
@@ -24,8 +39,33 @@ namespace lab5 {
 namespace {
 std::atomic<bool> g_running{true};
 
+// Point budget for /api/stats?bucket=auto when the client does not send max_points.
+constexpr std::size_t kDefaultMaxPoints = 2000;
+
+// How often the aggregation state is checkpointed for warm restart.
+constexpr std::int64_t kCheckpointIntervalMs = 10 * 1000;
+
+// How often raw and rollup rows past their retention are deleted.
+constexpr std::int64_t kPruneIntervalMs = 60 * 1000;
+
+// Samples taken from the simulator queue, log replay or bulk stdin per loop iteration.
+constexpr std::size_t kSourceBatch = 1024;
+
 void signal_handler(int) { g_running = false; }
 
+// Whole-string decimal parse of a query parameter; rejects empty, partial and out-of-range input.
+template <typename T>
+bool parse_number(const std::string& text, T& out) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    const auto [ptr, ec] = std::from_chars(first, last, out);
+    return first != last && ec == std::errc() && ptr == last;
+}
+
+HttpResponse bad_request(const std::string& param) {
+    return {"{\"error\":\"invalid " + param + "\"}", "application/json", "400 Bad Request"};
+}
+
 std::string samples_to_json(const std::vector<Sample>& v) {
     std::ostringstream oss;
     oss << '[';
@@ -38,18 +78,68 @@ std::string samples_to_json(const std::vector<Sample>& v) {
     return oss.str();
 }
 
+// Sliding windows served by /api/current: LAB7_WINDOWS="1m,5m,1h" or the defaults.
+std::vector<std::string> window_names() {
+    std::vector<std::string> names;
+    if (const char* env = std::getenv("LAB7_WINDOWS")) {
+        std::istringstream iss(env);
+        std::string name;
+        while (std::getline(iss, name, ',')) {
+            if (!name.empty()) names.push_back(name);
+        }
+    }
+    if (names.empty()) names = {"1m", "5m", "1h"};
+    return names;
+}
+
+// How long samples wait for stragglers before aggregation: LAB7_REORDER_MS or 2 s.
+std::int64_t reorder_delay_ms() {
+    if (const char* env = std::getenv("LAB7_REORDER_MS")) return std::strtoll(env, nullptr, 10);
+    return 2000;
+}
+
+// Number of simulated sensors: the configured count, LAB7_SIM_SENSORS or 1 (the default sensor only).
+std::size_t sim_sensor_count(const SimulatorConfig& config) {
+    if (config.sensors > 0) return config.sensors;
+    if (const char* env = std::getenv("LAB7_SIM_SENSORS")) return std::max<std::size_t>(1, std::strtoull(env, nullptr, 10));
+    return 1;
+}
+
+// Number of ingest shards: LAB7_SHARDS or one per hardware thread.
+std::size_t ingest_shard_count() {
+    if (const char* env = std::getenv("LAB7_SHARDS")) return std::max<std::size_t>(1, std::strtoull(env, nullptr, 10));
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Query string of a request path as key/value pairs ("/x?a=1&b=2" -> {a:1, b:2}).
+std::map<std::string, std::string> parse_query(const std::string& path) {
+    std::map<std::string, std::string> params;
+    auto qpos = path.find('?');
+    if (qpos == std::string::npos) return params;
+    std::istringstream iss(path.substr(qpos + 1));
+    std::string kv;
+    while (std::getline(iss, kv, '&')) {
+        auto eq = kv.find('=');
+        if (eq == std::string::npos) continue;
+        params[kv.substr(0, eq)] = kv.substr(eq + 1);
+    }
+    return params;
+}
+
 }  // namespace
 
 void request_stop() { g_running = false; }
 
-int run_main(bool simulate) {
+int run_main(bool simulate, const SimulatorConfig& sim_config, const ReplayConfig& replay_config, bool bulk_stdin) {
+    const bool replay = !replay_config.files.empty();
     g_running = true;
     std::signal(SIGINT, signal_handler);
 #ifndef _WIN32
     std::signal(SIGTERM, signal_handler);
 #endif
 
-    std::cout << "lab7 kiosk logger. Mode: " << (simulate ? "simulate" : "stdin") << "\n";
+    std::cout << "lab7 kiosk logger. Mode: "
+              << (replay ? "replay" : simulate ? "simulate" : bulk_stdin ? "bulk stdin" : "stdin") << "\n";
 
     Database db;
     std::string err;
@@ -58,39 +148,132 @@ int run_main(bool simulate) {
         return 1;
     }
 
-    Simulator sim;
-    if (simulate) sim.start();
-
-    Accum hour_acc;
-    Accum day_acc;
+    SensorRegistry sensors;
+    if (!sensors.load(db, err)) {
+        std::cerr << "Sensor registry load failed: " << err << "\n";
+        return 1;
+    }
 
-    auto now = Clock::now();
-    auto last_hour = hour_of(now);
-    auto last_day = day_of_year(now);
+    Simulator sim;
+    if (simulate) {
+        std::vector<SensorId> sim_sensors{kDefaultSensor};
+        for (std::size_t i = 1, n = sim_sensor_count(sim_config); i < n; ++i) {
+            if (auto id = sensors.intern(db, "sim" + std::to_string(i), err)) sim_sensors.push_back(*id);
+        }
+        sim.start(sim_sensors, sim_config);
+    }
 
-    int sample_count = 0;
+    LogReplay log_replay;
+    if (replay) {
+        std::vector<SensorId> replay_sensors;
+        for (const auto& file : replay_config.files) {
+            auto id = file.sensor.empty() ? std::optional<SensorId>(kDefaultSensor) : sensors.intern(db, file.sensor, err);
+            if (!id) {
+                std::cerr << "Cannot register sensor " << file.sensor << ": " << err << "\n";
+                return 1;
+            }
+            replay_sensors.push_back(*id);
+        }
+        if (!log_replay.open(replay_config, replay_sensors, err)) {
+            std::cerr << "Replay failed: " << err << "\n";
+            return 1;
+        }
+    }
 
-    auto flush_hour = [&](const TimePoint& ts) {
-        if (hour_acc.count == 0) return;
-        Sample avg{ts, hour_acc.avg()};
-        db.insert_hourly(avg, err);
-        db.prune_hourly(now_ms() - static_cast<std::int64_t>(30LL * 24 * 60 * 60 * 1000), err);
-        hour_acc.reset();
+    // Sensors are split across ingest shards; this thread only parses input and
+    // routes samples. Each shard keeps per-sensor rollups, sliding windows and
+    // reorder buffers (see ingest.h).
+    IngestConfig ingest_config;
+    ingest_config.windows = window_names();
+    ingest_config.reorder_delay_ms = reorder_delay_ms();
+    std::vector<std::unique_ptr<IngestShard>> shards;
+    for (std::size_t i = 0, n = ingest_shard_count(); i < n; ++i) {
+        shards.push_back(std::make_unique<IngestShard>(i, ingest_config));
+        if (!shards.back()->open(db_path(), err)) {
+            std::cerr << "DB open failed: " << err << "\n";
+            return 1;
+        }
+    }
+    auto shard_of = [&](SensorId sensor) -> IngestShard& { return *shards[shard_for(sensor, shards.size())]; };
+
+    const std::string ckpt_path = checkpoint_path();
+    std::string ckpt_err;
+    std::vector<std::pair<SensorId, std::int64_t>> restored;
+    auto restore = [&](SensorAggregates&& state) {
+        restored.emplace_back(state.sensor, state.applied_ms);
+        shard_of(state.sensor).restore(std::move(state));
+    };
+    if (load_checkpoint(ckpt_path, WindowSet(ingest_config.windows), restore, ckpt_err)) {
+        // Raw rows past each sensor's checkpointed state (its reorder buffer and
+        // everything stored after the checkpoint) are folded back in from the DB.
+        // Sensors first seen after the checkpoint start from the oldest saved state.
+        std::int64_t oldest_ms = std::numeric_limits<std::int64_t>::max();
+        for (const auto& [sensor, applied_ms] : restored) oldest_ms = std::min(oldest_ms, applied_ms);
+        std::vector<std::pair<SensorId, std::int64_t>> pending = restored;
+        for (const auto& [sensor, name] : sensors.list()) {
+            const bool known = std::any_of(restored.begin(), restored.end(), [&](const auto& r) { return r.first == sensor; });
+            if (!known && !restored.empty()) pending.emplace_back(sensor, oldest_ms);
+        }
+        std::size_t replayed = 0;
+        std::vector<Sample> rows;
+        for (const auto& [sensor, applied_ms] : pending) {
+            rows.clear();
+            if (!db.query_range("measurements", sensor, applied_ms + 1, std::numeric_limits<std::int64_t>::max(), rows, err)) {
+                std::cerr << "Checkpoint replay failed: " << err << "\n";
+                continue;
+            }
+            shard_of(sensor).replay(sensor, rows);
+            replayed += rows.size();
+        }
+        std::cout << "Restored aggregation state of " << restored.size() << " sensor(s) from " << ckpt_path << ", replayed "
+                  << replayed << " raw row(s)\n";
+    } else if (!ckpt_err.empty()) {
+        std::cerr << "Checkpoint ignored: " << ckpt_err << "\n";
+    }
+    std::int64_t last_checkpoint_ms = now_ms();
+
+    const unsigned cores = std::thread::hardware_concurrency();
+    for (std::size_t i = 0; i < shards.size(); ++i) shards[i]->start(cores > 1 ? static_cast<int>(i % cores) : -1);
+    std::cout << "Ingest shards: " << shards.size() << "\n";
+
+    auto checkpoint = [&]() {
+        // Shards are copied one at a time and keep ingesting while the file is written;
+        // each sensor's applied_ms marks what a restart has to replay.
+        std::vector<SensorAggregates> aggregates;
+        for (auto& shard : shards) shard->snapshot(aggregates);
+        if (!save_checkpoint(ckpt_path, now_ms(), aggregates, ckpt_err)) {
+            std::cerr << "Checkpoint failed: " << ckpt_err << "\n";
+        }
+        last_checkpoint_ms = now_ms();
     };
 
-    auto flush_day = [&](const TimePoint& ts) {
-        if (day_acc.count == 0) return;
-        Sample avg{ts, day_acc.avg()};
-        db.insert_daily(avg, err);
-        db.prune_daily_current_year(err);
-        day_acc.reset();
+    // Retention is measured against the newest sample rather than the wall clock,
+    // so fast-forward simulations of other dates keep their data. /api/stats plans
+    // tiers against the same clock; it is read from the HTTP thread.
+    std::atomic<std::int64_t> data_now{0};
+    auto data_clock = [&]() {
+        const std::int64_t ms = data_now.load(std::memory_order_relaxed);
+        return ms != 0 ? ms : now_ms();
+    };
+    std::int64_t last_prune_ms = 0;
+    auto prune = [&]() {
+        const std::int64_t data_now_ms = data_now.load(std::memory_order_relaxed);
+        db.prune_measurements(data_now_ms - kDayMs, err);
+        for (const auto& level : kRollupLevels) {
+            if (level.retention_ms > 0) {
+                db.prune_rollup(level.table, data_now_ms - level.retention_ms, err);
+            } else {
+                db.prune_daily_current_year(data_now_ms, err);
+            }
+        }
+        last_prune_ms = now_ms();
     };
 
     const fs::path web_root_path = fs::path(web_root());
     const fs::path dist_root = web_root_path / "dist";
     const fs::path static_root = fs::exists(dist_root) ? dist_root : web_root_path;
 
-    auto serve_static = [&](const std::string& req_path) -> std::optional<std::pair<std::string, std::string>> {
+    auto serve_static = [&](const std::string& req_path) -> std::optional<HttpResponse> {
         std::string rel = req_path;
         if (!rel.empty() && rel[0] == '/') rel.erase(0, 1);
         fs::path target = static_root / (rel.empty() ? fs::path("index.html") : fs::path(rel));
@@ -114,11 +297,11 @@ int run_main(bool simulate) {
         else if (ext == ".png") content_type = "image/png";
         else if (ext == ".jpg" || ext == ".jpeg") content_type = "image/jpeg";
         else if (ext == ".woff2") content_type = "font/woff2";
-        return std::make_pair(buf.str(), content_type);
+        return HttpResponse{buf.str(), content_type};
     };
 
     HttpServer server;
-    auto handler = [&](const std::string& req) -> std::pair<std::string, std::string> {
+    auto handler = [&](const std::string& req) -> HttpResponse {
         auto pos = req.find(' ');
         if (pos == std::string::npos) return {"{}", "application/json"};
         auto pos2 = req.find(' ', pos + 1);
@@ -127,38 +310,167 @@ int run_main(bool simulate) {
         auto qmark = path_no_query.find('?');
         if (qmark != std::string::npos) path_no_query = path_no_query.substr(0, qmark);
 
-        if (path == "/api/current") {
-            auto latest = db.latest_measurement(err);
+        if (path_no_query == "/api/sensors") {
+            std::ostringstream o;
+            o << '[';
+            const auto list = sensors.list();
+            for (std::size_t i = 0; i < list.size(); ++i) {
+                if (i) o << ',';
+                o << "{\"id\":" << list[i].first << ",\"name\":\"" << json_escape(list[i].second) << "\"}";
+            }
+            o << ']';
+            return {o.str(), "application/json"};
+        }
+
+        const auto query = parse_query(path);
+        SensorId sensor = kDefaultSensor;
+        if (auto it = query.find("sensor"); it != query.end()) {
+            auto id = sensors.find(it->second);
+            if (!id) return {"{}", "application/json"};
+            sensor = *id;
+        }
+
+        if (path_no_query == "/api/current") {
+            std::optional<Sample> latest;
+            std::vector<WindowSnapshot> stats;
+            if (auto view = shard_of(sensor).current(sensor)) {
+                latest = view->latest;
+                stats = view->windows;
+            }
+            if (!latest) latest = db.latest_measurement(sensor, err);
             if (!latest) return {"{}", "application/json"};
             std::ostringstream o;
             auto ms = duration_cast<milliseconds>(latest->ts.time_since_epoch()).count();
-            o << "{\"epoch_ms\":" << ms << ",\"value\":" << latest->value << "}";
+            o << "{\"sensor\":" << sensor << ",\"epoch_ms\":" << ms << ",\"value\":" << latest->value << ",\"windows\":{";
+            for (std::size_t i = 0; i < stats.size(); ++i) {
+                const auto& w = stats[i];
+                if (i) o << ',';
+                o << '"' << w.name << "\":{\"count\":" << w.count << ",\"avg\":" << w.avg << ",\"min\":" << w.min
+                  << ",\"max\":" << w.max << '}';
+            }
+            o << "}}";
             return {o.str(), "application/json"};
         }
 
         if (path.rfind("/api/stats", 0) == 0) {
-            std::string table = "measurements";
+            std::string bucket = "auto";
+            std::size_t max_points = 0;
             std::int64_t start = now_ms() - 3600 * 1000;
             std::int64_t end = now_ms();
-            auto qpos = path.find('?');
-            if (qpos != std::string::npos) {
-                auto qs = path.substr(qpos + 1);
-                std::istringstream iss(qs);
-                std::string kv;
-                while (std::getline(iss, kv, '&')) {
-                    auto eq = kv.find('=');
-                    if (eq == std::string::npos) continue;
-                    auto key = kv.substr(0, eq);
-                    auto val = kv.substr(eq + 1);
-                    if (key == "bucket") table = val == "hourly" ? "hourly_avg" : (val == "daily" ? "daily_avg" : "measurements");
-                    else if (key == "start") start = std::stoll(val);
-                    else if (key == "end") end = std::stoll(val);
+            for (const auto& [key, val] : query) {
+                if (key == "bucket") bucket = val;
+                else if (key == "max_points") {
+                    if (!parse_number(val, max_points)) return bad_request("max_points");
+                } else if (key == "start") {
+                    if (!parse_number(val, start)) return bad_request("start");
+                } else if (key == "end") {
+                    if (!parse_number(val, end)) return bad_request("end");
                 }
             }
+
+            if (bucket != "auto") {
+                // An explicit tier is returned as is. With max_points it is paged, max_points
+                // rows at a time, and next_start is where the following page begins; without
+                // it the whole range is returned, as the GUI's fixed-tier views expect.
+                const auto* level = find_rollup_level(bucket);
+                const std::string table = level ? level->table : "measurements";
+                std::vector<Sample> out;
+                if (!db.query_range(table, sensor, start, end, out, err, max_points ? max_points + 1 : 0)) {
+                    return {"{}", "application/json"};
+                }
+                std::ostringstream o;
+                o << "{\"bucket\":\"" << table << "\"";
+                if (max_points && out.size() > max_points) {
+                    auto ms_of = [](const Sample& s) { return duration_cast<milliseconds>(s.ts.time_since_epoch()).count(); };
+                    std::int64_t next_start = ms_of(out.back());
+                    out.pop_back();
+                    // Raw rows can share a millisecond: end the page before next_start so
+                    // none of them is sent twice. A millisecond holding more than a whole
+                    // page is sent whole and the next page starts after it.
+                    std::size_t keep = out.size();
+                    while (keep > 0 && ms_of(out[keep - 1]) == next_start) --keep;
+                    if (keep > 0) {
+                        out.resize(keep);
+                    } else {
+                        out.clear();
+                        if (!db.query_range(table, sensor, next_start, next_start, out, err)) return {"{}", "application/json"};
+                        ++next_start;
+                    }
+                    o << ",\"next_start\":" << next_start;
+                }
+                o << ",\"data\":" << samples_to_json(out) << "}";
+                return {o.str(), "application/json"};
+            }
+
+            if (max_points == 0) max_points = kDefaultMaxPoints;
+            const auto segments = plan_tiers(start, end, max_points, data_clock(), [&](std::int64_t from, std::int64_t to) {
+                return db.count_range("measurements", sensor, from, to, err);
+            });
             std::vector<Sample> out;
-            if (!db.query_range(table, start, end, out, err)) return {"{}", "application/json"};
+            std::ostringstream tiers;
+            std::string finest = "raw";
+            for (std::size_t i = 0; i < segments.size(); ++i) {
+                const auto& seg = segments[i];
+                const std::string name = seg.level ? seg.level->name : "raw";
+                if (!db.query_range(seg.level ? seg.level->table : "measurements", sensor, seg.start_ms, seg.end_ms, out, err)) {
+                    return {"{}", "application/json"};
+                }
+                if (i) tiers << ',';
+                tiers << "{\"bucket\":\"" << name << "\",\"start\":" << seg.start_ms << ",\"end\":" << seg.end_ms << "}";
+                finest = name;
+            }
             std::ostringstream o;
-            o << "{\"bucket\":\"" << table << "\",\"data\":" << samples_to_json(out) << "}";
+            o << "{\"bucket\":\"" << finest << "\",\"tiers\":[" << tiers.str() << "],\"data\":" << samples_to_json(out) << "}";
+            return {o.str(), "application/json"};
+        }
+
+        if (path_no_query == "/api/aggregate") {
+            std::int64_t step = 5LL * 60 * 1000;
+            std::vector<AggFn> fns{kAggAvg, kAggMin, kAggMax};
+            std::int64_t start = now_ms() - 3600 * 1000;
+            std::int64_t end = now_ms();
+            for (const auto& [key, val] : query) {
+                if (key == "step") {
+                    auto parsed = parse_step(val);
+                    if (!parsed) return bad_request("step");
+                    step = *parsed;
+                } else if (key == "fn") {
+                    fns = parse_agg_fns(val);
+                    if (fns.empty()) return bad_request("fn");
+                } else if (key == "start") {
+                    if (!parse_number(val, start)) return bad_request("start");
+                } else if (key == "end") {
+                    if (!parse_number(val, end)) return bad_request("end");
+                }
+            }
+
+            std::vector<std::int64_t> ts;
+            std::vector<double> values;
+            if (!db.query_columns("measurements", sensor, start, end, ts, values, err)) return {"{}", "application/json"};
+            std::vector<AggBucket> buckets;
+            aggregate_columns(ts.data(), values.data(), ts.size(), step, buckets);
+
+            std::ostringstream o;
+            o << "{\"step\":" << step << ",\"columns\":[\"epoch_ms\"";
+            for (auto fn : fns) o << ",\"" << agg_fn_name(fn) << '"';
+            o << "],\"data\":[";
+            for (std::size_t i = 0; i < buckets.size(); ++i) {
+                const auto& b = buckets[i];
+                if (i) o << ',';
+                o << '[' << b.start_ms;
+                for (auto fn : fns) {
+                    o << ',';
+                    switch (fn) {
+                    case kAggAvg: o << b.sum / static_cast<double>(b.count); break;
+                    case kAggMin: o << b.min; break;
+                    case kAggMax: o << b.max; break;
+                    case kAggSum: o << b.sum; break;
+                    case kAggCount: o << b.count; break;
+                    }
+                }
+                o << ']';
+            }
+            o << "]}";
             return {o.str(), "application/json"};
         }
 
@@ -175,68 +487,126 @@ int run_main(bool simulate) {
         std::cerr << "HTTP start failed: " << err << "\n";
     }
 
+    std::uint64_t routed = 0;
+    const auto ingest_started = steady_clock::now();
+    auto run_timers = [&]() {
+        if (now_ms() - last_prune_ms >= kPruneIntervalMs) prune();
+        if (now_ms() - last_checkpoint_ms >= kCheckpointIntervalMs) checkpoint();
+    };
     auto process_sample = [&](const Sample& s) {
-        const auto h = hour_of(s.ts);
-        const auto d = day_of_year(s.ts);
-
-        if (h != last_hour) {
-            flush_hour(s.ts);
-        }
-        last_hour = h;
-
-        if (d != last_day) {
-            flush_day(s.ts);
+        shard_of(s.sensor).push(s);
+        ++routed;
+        const std::int64_t ms = duration_cast<milliseconds>(s.ts.time_since_epoch()).count();
+        if (ms > data_now.load(std::memory_order_relaxed)) data_now.store(ms, std::memory_order_relaxed);
+        run_timers();
+    };
+    // Batched sources: one ring push per shard and one timer check per batch.
+    std::vector<std::vector<Sample>> shard_batches(shards.size());
+    auto process_batch = [&](const Sample* samples, std::size_t n) {
+        std::int64_t newest = data_now.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i) {
+            newest = std::max<std::int64_t>(newest, duration_cast<milliseconds>(samples[i].ts.time_since_epoch()).count());
         }
-        last_day = d;
-
-        hour_acc.add(s.value);
-        day_acc.add(s.value);
-
-        db.insert_measurement(s, err);
-        ++sample_count;
-        if (sample_count % 50 == 0) {
-            db.prune_measurements(now_ms() - static_cast<std::int64_t>(24LL * 60 * 60 * 1000), err);
-            db.prune_hourly(now_ms() - static_cast<std::int64_t>(30LL * 24 * 60 * 60 * 1000), err);
-            db.prune_daily_current_year(err);
+        data_now.store(newest, std::memory_order_relaxed);
+        if (shards.size() == 1) {
+            shards[0]->push_batch(samples, n);
+        } else {
+            for (std::size_t i = 0; i < n; ++i) shard_batches[shard_for(samples[i].sensor, shards.size())].push_back(samples[i]);
+            for (std::size_t i = 0; i < shards.size(); ++i) {
+                if (shard_batches[i].empty()) continue;
+                shards[i]->push_batch(shard_batches[i].data(), shard_batches[i].size());
+                shard_batches[i].clear();
+            }
         }
+        routed += n;
+        run_timers();
     };
 
+    std::vector<Sample> batch(kSourceBatch);
+    BulkReader bulk_reader(stdin);
     while (g_running) {
-        Sample s;
-        bool got = false;
+        if (replay) {
+            // Nothing due yet (slow playback) or the logs are exhausted.
+            const std::size_t n = log_replay.next_batch(batch.data(), batch.size());
+            if (n == 0 && log_replay.finished()) break;
+            process_batch(batch.data(), n);
+            continue;
+        }
         if (simulate) {
-            got = sim.pop(s);
-        } else {
+            // No samples means the simulator was stopped or finished a fast-forward run.
+            const std::size_t n = sim.pop_batch(batch.data(), batch.size());
+            if (n == 0) break;
+            process_batch(batch.data(), n);
+            continue;
+        }
+        if (bulk_stdin) {
+            const std::size_t n = bulk_reader.next_batch(batch.data(), batch.size());
+            if (n == 0) break;
+            process_batch(batch.data(), n);
+            continue;
+        }
+
+        Sample s;
+        {
             std::string line;
             if (!std::getline(std::cin, line)) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 continue;
             }
+            // "<value>" for the default sensor or "<sensor> <value>".
             std::istringstream iss(line);
+            std::string first;
             double val;
-            if (!(iss >> val)) {
-                std::cerr << "Invalid input, expected number.\n";
-                continue;
+            if (!(iss >> first)) continue;
+            if (iss >> val) {
+                auto id = sensors.intern(db, first, err);
+                if (!id) {
+                    std::cerr << "Cannot register sensor " << first << ": " << err << "\n";
+                    continue;
+                }
+                s.sensor = *id;
+            } else {
+                char* end = nullptr;
+                val = std::strtod(first.c_str(), &end);
+                if (*end != '\0') {
+                    std::cerr << "Invalid input, expected number or \"sensor number\".\n";
+                    continue;
+                }
             }
             s.ts = Clock::now();
             s.value = val;
-            got = true;
-        }
-
-        if (got) {
-            process_sample(s);
-        } else if (!simulate) {
-            break;
         }
+        process_sample(s);
     }
 
-    if (simulate) sim.stop();
+    if (simulate) {
+        sim.stop();
+        const RingStats q = sim.queue_stats();
+        std::cout << "Simulator queue: " << q.pushed << " pushed, " << q.dropped << " dropped, " << q.producer_waits
+                  << " producer / " << q.consumer_waits << " consumer waits, " << q.wakeups << " wakeups\n";
+    }
+    if (replay) {
+        std::cout << "Replayed " << log_replay.lines() << " log lines (" << log_replay.skipped() << " unparsable)\n";
+    }
+    if (bulk_stdin) {
+        std::cout << "Read " << bulk_reader.lines() << " stdin lines (" << bulk_reader.skipped() << " unparsable)\n";
+    }
     server.stop();
 
-    flush_hour(Clock::now());
-    flush_day(Clock::now());
+    for (auto& shard : shards) shard->stop();
+    const double ingest_s = duration<double>(steady_clock::now() - ingest_started).count();
+    std::cout << "Ingested " << routed << " samples in " << ingest_s << " s";
+    if (ingest_s > 0) std::cout << " (" << static_cast<long long>(static_cast<double>(routed) / ingest_s) << " samples/s)";
+    std::cout << "\n";
+
+    // Save open buckets first: the flush below writes provisional rows that are
+    // overwritten once the restored buckets close after a restart.
+    checkpoint();
+    for (auto& shard : shards) shard->flush_open();
 
     return 0;
 }
 
+int run_main(bool simulate) { return run_main(simulate, SimulatorConfig{}, ReplayConfig{}, false); }
+
 }  // namespace lab5
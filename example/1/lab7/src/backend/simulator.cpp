@@ -1,80 +1,213 @@
 ﻿#include "simulator.h"
 
-#include <random>
 #include <algorithm>
 #include <cmath>
 
 #include "common.h"
+#include "rollup.h"
 
 namespace lab5 {
 
-void Simulator::start() {
+namespace {
+
+constexpr double kMeanTemp       = 15.0;
+constexpr double kDailyAmplitude = 7.0;
+constexpr double kMinTemp        = -20.0;
+constexpr double kMaxTemp        = 40.0;
+constexpr double kWeatherLimit   = 5.0;
+constexpr double kDriftSigma     = 0.02;
+constexpr double kNoiseSigma     = 0.15;
+constexpr double kNoiseRho       = 0.95;
+constexpr double kTwoPi          = 6.283185307179586;
+
+constexpr std::uint64_t kGolden = 0x9e3779b97f4a7c15ULL;
+constexpr unsigned kSpins = 64;
+
+// SplitMix64 finalizer. Hashing a counter instead of advancing a generator keeps
+// each sensor's stream independent of how sensors are split between threads.
+inline std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline double uniform(std::uint64_t h) { return static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0); }
+
+// Close to a standard normal: the Irwin-Hall sum of the four 16-bit parts of h.
+// Unlike Box-Muller it needs no log/sqrt/cos, so the step loop vectorizes.
+inline double gaussian(std::uint64_t h) {
+    const auto sum = static_cast<std::int32_t>((h & 0xffff) + ((h >> 16) & 0xffff) + ((h >> 32) & 0xffff) + (h >> 48));
+    return (static_cast<double>(sum) - 131070.0) * (1.7320508075688772 / 65536.0);
+}
+
+// One worker's sensors as parallel arrays, so a step is a single loop over doubles.
+struct SensorBank {
+    std::vector<std::uint64_t> key;
+    std::vector<double> mean;
+    std::vector<double> amplitude;
+    std::vector<double> cos_phase;
+    std::vector<double> sin_phase;
+    std::vector<double> weather;
+    std::vector<double> noise;
+    std::vector<double> value;
+
+    SensorBank(const SensorId* ids, std::size_t n, std::uint64_t seed)
+        : key(n), mean(n), amplitude(n), cos_phase(n), sin_phase(n), weather(n, 0.0), noise(n, 0.0), value(n, 0.0) {
+        for (std::size_t i = 0; i < n; ++i) {
+            key[i] = mix(seed + kGolden * (static_cast<std::uint64_t>(ids[i]) + 1));
+            mean[i] = kMeanTemp + 6.0 * (uniform(mix(key[i] ^ 1)) - 0.5);
+            amplitude[i] = kDailyAmplitude * (0.7 + 0.6 * uniform(mix(key[i] ^ 2)));
+            // Shifts the daily curve by up to two hours either way.
+            const double phase = kTwoPi * 4.0 * (uniform(mix(key[i] ^ 3)) - 0.5) / 24.0;
+            cos_phase[i] = std::cos(phase);
+            sin_phase[i] = std::sin(phase);
+        }
+    }
+
+    // Advances every sensor by one step; (sin_a, cos_a) is the shared daily angle.
+    void step(std::uint64_t index, double sin_a, double cos_a) {
+        const std::size_t n = key.size();
+        const std::uint64_t drift_counter = index * 2 * kGolden;
+        const std::uint64_t noise_counter = drift_counter + kGolden;
+        const std::uint64_t* k = key.data();
+        const double* m = mean.data();
+        const double* amp = amplitude.data();
+        const double* cp = cos_phase.data();
+        const double* sp = sin_phase.data();
+        double* __restrict w = weather.data();
+        double* __restrict z = noise.data();
+        double* __restrict out = value.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            const double drift = w[i] + kDriftSigma * gaussian(mix(k[i] + drift_counter));
+            w[i] = std::min(std::max(drift, -kWeatherLimit), kWeatherLimit);
+            z[i] = kNoiseRho * z[i] + kNoiseSigma * gaussian(mix(k[i] + noise_counter));
+            // sin(a - phase) by angle subtraction: one sin/cos per step for all sensors.
+            const double cycle = sin_a * cp[i] - cos_a * sp[i];
+            out[i] = std::min(std::max(m[i] + amp[i] * cycle + w[i] + z[i], kMinTemp), kMaxTemp);
+        }
+    }
+};
+
+}  // namespace
+
+void Simulator::start(const std::vector<SensorId>& sensors, const SimulatorConfig& config) {
+    sensors_ = sensors;
+    config_ = config;
+    if (config_.seed == 0) config_.seed = static_cast<std::uint64_t>(now_ms());
+    // In fast-forward the generator outruns ingest; dropping would break reproducibility.
+    queue_ = std::make_unique<MpscRing<Sample>>(config_.queue_capacity,
+                                                config_.fast_forward ? Overflow::kBlock : config_.overflow);
+
+    std::size_t threads = config_.threads;
+    if (threads == 0) {
+        const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(cores, (sensors_.size() + kSensorsPerWorker - 1) / kSensorsPerWorker);
+    }
+    threads = std::max<std::size_t>(1, std::min(threads, sensors_.size()));
+
+    worker_count_ = threads;
+    active_ = threads;
+    arrived_ = 0;
     running_ = true;
-    thread_ = std::thread([this]() { run(); });
+    for (std::size_t w = 0; w < threads; ++w) {
+        const std::size_t begin = sensors_.size() * w / threads;
+        const std::size_t end = sensors_.size() * (w + 1) / threads;
+        workers_.emplace_back([this, begin, end]() { run(begin, end); });
+    }
 }
 
 void Simulator::stop() {
     running_ = false;
-    if (thread_.joinable()) thread_.join();
-}
-
-bool Simulator::pop(Sample& out) {
-    std::unique_lock<std::mutex> lk(mu_);
-    cv_.wait(lk, [&] { return !queue_.empty() || !running_; });
-    if (queue_.empty()) return false;
-    out = queue_.front();
-    queue_.pop();
-    return true;
+    released_.notify();
+    if (queue_) queue_->close();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
 }
 
-void Simulator::run() {
-    using namespace std::chrono;
+bool Simulator::pop(Sample& out) { return pop_batch(&out, 1) == 1; }
 
-    std::mt19937 rng(static_cast<unsigned>(now_ms()));
-    std::normal_distribution<double> weatherDrift(0.0, 0.02);
-    std::normal_distribution<double> shortNoise(0.0, 0.15);
+std::size_t Simulator::pop_batch(Sample* out, std::size_t max) { return queue_ ? queue_->pop_batch(out, max) : 0; }
 
-    double simHours = 0.0;
-    double weatherOffset = 0.0;
-    double noiseState = 0.0;
-    constexpr double noiseRho = 0.95;
+RingStats Simulator::queue_stats() const { return queue_ ? queue_->stats() : RingStats{}; }
 
-    constexpr double meanTemp       = 15.0;
-    constexpr double dailyAmplitude = 7.0;
-    constexpr double minTemp        = -20.0;
-    constexpr double maxTemp        = 40.0;
+bool Simulator::step_barrier() {
+    const std::uint32_t generation = generation_.load(std::memory_order_acquire);
+    if (arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 == worker_count_) {
+        arrived_.store(0, std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_release);
+        released_.notify();
+        return running_;
+    }
+    for (unsigned spins = 0; generation_.load(std::memory_order_acquire) == generation; ++spins) {
+        if (!running_) return false;
+        if (spins < kSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+        const std::uint32_t ticket = released_.prepare_wait();
+        if (generation_.load() != generation || !running_) {
+            released_.cancel_wait();
+            continue;
+        }
+        released_.wait(ticket);
+    }
+    return running_;
+}
 
-    constexpr auto   step         = seconds(2);
-    constexpr double simStepHours = 10.0 / 60.0;
-    constexpr double twoPi        = 6.283185307179586;
+void Simulator::run(std::size_t begin, std::size_t end) {
+    using namespace std::chrono;
 
-    while (running_) {
-        simHours += simStepHours;
-        double hourOfDay  = std::fmod(simHours, 24.0);
-        double dailyCycle = std::sin(twoPi * (hourOfDay - 15.0) / 24.0);
+    SensorBank bank(sensors_.data() + begin, end - begin, config_.seed);
+    std::vector<Sample> batch(end - begin);
+    for (std::size_t i = 0; i < batch.size(); ++i) batch[i].sensor = sensors_[begin + i];
 
-        weatherOffset += weatherDrift(rng);
-        weatherOffset = std::clamp(weatherOffset, -5.0, 5.0);
+    const auto       step         = milliseconds(config_.step_ms);
+    constexpr double simStepHours = 10.0 / 60.0;
+    constexpr double msPerHour    = 3600.0 * 1000.0;
 
-        noiseState = noiseRho * noiseState + shortNoise(rng);
+    const std::int64_t origin_ms = config_.start_ms ? config_.start_ms : now_ms();
+    std::int64_t virtual_ms = origin_ms;
+    // Local day containing virtual_ms: the daily peak follows the clock the
+    // rollups and the UI use, not UTC. Refreshed once per simulated day.
+    std::int64_t day_start_ms = 0;
+    std::int64_t day_end_ms = 0;
 
-        double value = meanTemp
-                     + dailyAmplitude * dailyCycle
-                     + weatherOffset
-                     + noiseState;
+    for (std::uint64_t index = 0; running_; ++index) {
+        if (config_.fast_forward && config_.duration_ms > 0 && virtual_ms - origin_ms >= config_.duration_ms) break;
 
-        value = std::clamp(value, minTemp, maxTemp);
+        if (config_.fast_forward && (virtual_ms < day_start_ms || virtual_ms >= day_end_ms)) {
+            day_start_ms = bucket_start(virtual_ms, kDayMs);
+            day_end_ms = bucket_end(day_start_ms, kDayMs);
+        }
+        const double hourOfDay = config_.fast_forward ? static_cast<double>(virtual_ms - day_start_ms) / msPerHour
+                                                      : std::fmod(static_cast<double>(index + 1) * simStepHours, 24.0);
+        const double angle = kTwoPi * (hourOfDay - 15.0) / 24.0;
+        bank.step(index, std::sin(angle), std::cos(angle));
+
+        const auto now = config_.fast_forward ? TimePoint(milliseconds(virtual_ms)) : Clock::now();
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            batch[i].ts = now;
+            batch[i].value = bank.value[i];
+        }
+        queue_->push_batch(batch.data(), batch.size());
 
-        Sample s{Clock::now(), value};
-        {
-            std::lock_guard<std::mutex> lk(mu_);
-            queue_.push(s);
+        if (config_.fast_forward) {
+            virtual_ms += config_.step_ms;
+        } else {
+            std::this_thread::sleep_for(step);
         }
-        cv_.notify_one();
-        std::this_thread::sleep_for(step);
+        // Lockstep keeps the merged stream in time order for the reorder buffer.
+        if (!step_barrier()) break;
     }
 
-    cv_.notify_all();
+    if (active_.fetch_sub(1) == 1) {
+        running_ = false;
+        queue_->close();
+    }
 }
 
 }  // namespace lab5
@@ -0,0 +1,89 @@
+// Test: every line of a --bulk load becomes its own raw row. Plain "value"
+// lines read in one batch share their read-time timestamp and must still be
+// stored as separate rows; the stored row count must match the input.
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bulk_input.h"
+#include "db.h"
+#include "test_util.h"
+
+using lab5::test::check;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Loads text through BulkReader into a fresh DB and returns the stored raw row count.
+std::size_t load(const std::string& text, const std::string& path, std::uint64_t& parsed) {
+    lab5::test::remove_db(path);
+
+    std::FILE* in = std::tmpfile();
+    if (!in) return 0;
+    std::fwrite(text.data(), 1, text.size(), in);
+    std::rewind(in);
+
+    lab5::Database db;
+    std::string err;
+    if (!db.open(path, err)) {
+        std::fprintf(stderr, "DB open failed: %s\n", err.c_str());
+        std::fclose(in);
+        return 0;
+    }
+    lab5::BulkReader reader(in, 4096);
+    std::vector<lab5::Sample> batch(1024);
+    parsed = 0;
+    while (const std::size_t n = reader.next_batch(batch.data(), batch.size())) {
+        if (!db.insert_measurements(batch.data(), n, err)) std::fprintf(stderr, "insert failed: %s\n", err.c_str());
+        parsed += n;
+    }
+    std::fclose(in);
+    const std::size_t rows = db.count_range("measurements", lab5::kDefaultSensor, 0, lab5::now_ms() + 3600 * 1000, err);
+    lab5::test::remove_db(path);
+    return rows;
+}
+
+bool parses(const char* line, std::int64_t& ms, double& value) {
+    return lab5::parse_bulk_line(line, line + std::strlen(line), 42, ms, value);
+}
+
+void test_trailing_blanks() {
+    std::int64_t ms = 0;
+    double value = 0.0;
+    check(parses("21 \r", ms, value) && ms == 42 && value == 21.0, "integer value with trailing blank");
+    check(parses("21.5\t", ms, value) && ms == 42 && value == 21.5, "decimal value with trailing tab");
+    check(parses("1700000000000  21.5 ", ms, value) && ms == 1700000000000LL && value == 21.5, "timestamped line with blanks");
+    check(!parses("1700000000000 x", ms, value), "timestamp followed by garbage");
+}
+
+}  // namespace
+
+int main() {
+    test_trailing_blanks();
+
+    const std::string path = (fs::temp_directory_path() / "lab7_test_bulk_input.db").string();
+    std::uint64_t parsed = 0;
+
+    std::string plain;
+    for (int i = 0; i < 5000; ++i) plain += std::to_string(20.0 + i % 7) + "\n";
+    const std::size_t plain_rows = load(plain, path, parsed);
+    check(parsed == 5000, "all plain lines parsed");
+    check(plain_rows == 5000, "one stored row per plain line");
+
+    // Explicit timestamps are kept as given, including repeated ones.
+    const std::int64_t base = lab5::now_ms() - 60 * 1000;
+    std::string mixed;
+    for (int i = 0; i < 3000; ++i) {
+        mixed += i % 3 ? std::to_string(base + i / 3) + " 1.5\n" : "2.5\n";
+    }
+    const std::size_t mixed_rows = load(mixed, path, parsed);
+    check(parsed == 3000, "all mixed lines parsed");
+    check(mixed_rows == 3000, "one stored row per mixed line");
+
+    if (plain_rows != 5000 || mixed_rows != 3000) {
+        std::fprintf(stderr, "stored %zu of 5000 plain and %zu of 3000 mixed lines\n", plain_rows, mixed_rows);
+    }
+    return lab5::test::finish();
+}
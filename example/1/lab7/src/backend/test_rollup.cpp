@@ -0,0 +1,89 @@
+// Test: late samples reach every rollup level, including buckets that closed
+// before they arrived. Samples run from 23:30 to 02:00 local time, so the day and
+// the 23:00 hour are closed when a sample from 23:59:50 comes in; every stored row
+// covering it is then compared with the average of the raw rows of its bucket.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "ingest.h"
+#include "test_util.h"
+
+using namespace std::chrono;
+using lab5::test::check;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::int64_t kStepMs = 10 * 1000;
+constexpr std::int64_t kBeforeMs = 30 * 60 * 1000;
+constexpr std::int64_t kAfterMs = 2 * 60 * 60 * 1000;
+
+lab5::Sample at(std::int64_t ms, double value) { return lab5::Sample{lab5::TimePoint(milliseconds(ms)), value, lab5::kDefaultSensor}; }
+
+void test_cascade(std::int64_t midnight) {
+    lab5::RollupCascade cascade;
+    std::vector<lab5::RollupRow> closed;
+    std::uint32_t mask = 0;
+    for (std::int64_t t = midnight - kBeforeMs; t < midnight + kAfterMs; t += kStepMs) mask |= cascade.add(t, 1.0, closed);
+    check(mask == 0, "in-order samples miss nothing");
+
+    // Only the daily bucket of the previous day is still held in memory; the finer
+    // levels are left to the raw recompute.
+    closed.clear();
+    mask = cascade.add(midnight - kStepMs, 2.0, closed);
+    check(mask == 0xFu, "1m..1h buckets reported for raw recompute");
+    check(closed.size() == 1 && closed[0].level == lab5::kRollupLevelCount - 1, "closed day corrected in memory");
+    check(!closed.empty() && closed[0].acc.count == static_cast<std::size_t>(kBeforeMs / kStepMs + 1), "day includes the late sample");
+}
+
+void test_shard_rows(std::int64_t midnight, const std::string& path) {
+    lab5::test::remove_db(path);
+
+    std::string err;
+    lab5::IngestShard shard(0, lab5::IngestConfig{});
+    if (!shard.open(path, err)) {
+        std::fprintf(stderr, "DB open failed: %s\n", err.c_str());
+        ++lab5::test::failures;
+        return;
+    }
+    shard.start(-1);
+    for (std::int64_t t = midnight - kBeforeMs; t < midnight + kAfterMs; t += kStepMs) shard.push(at(t, 10.0));
+    const std::int64_t late = midnight - kStepMs + 1;
+    shard.push(at(late, 100.0));
+    shard.stop();
+    shard.flush_open();
+
+    lab5::Database db;
+    if (!db.open(path, err)) {
+        std::fprintf(stderr, "DB reopen failed: %s\n", err.c_str());
+        ++lab5::test::failures;
+        return;
+    }
+    for (const auto& level : lab5::kRollupLevels) {
+        const std::int64_t start = lab5::bucket_start(late, level.period_ms);
+        lab5::Accum raw;
+        std::vector<lab5::Sample> rows;
+        db.sum_range("measurements", lab5::kDefaultSensor, start, lab5::bucket_end(start, level.period_ms), raw, err);
+        db.query_range(level.table, lab5::kDefaultSensor, start, start, rows, err);
+        const bool ok = rows.size() == 1 && std::fabs(rows[0].value - raw.avg()) < 1e-9;
+        if (!ok) {
+            std::fprintf(stderr, "%s bucket %lld: %zu rows, stored %.17g, raw %.17g\n", level.name, static_cast<long long>(start),
+                         rows.size(), rows.empty() ? NAN : rows[0].value, raw.avg());
+        }
+        check(ok, "stored rollup matches raw average");
+    }
+    lab5::test::remove_db(path);
+}
+
+}  // namespace
+
+int main() {
+    // Local midnight of an arbitrary past day, so bucket boundaries follow the time zone.
+    const std::int64_t midnight = lab5::bucket_end(lab5::bucket_start(1741600000000LL, lab5::kDayMs), lab5::kDayMs);
+    test_cascade(midnight);
+    test_shard_rows(midnight, (fs::temp_directory_path() / "lab7_test_rollup.db").string());
+    return lab5::test::finish();
+}
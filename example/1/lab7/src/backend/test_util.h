@@ -0,0 +1,32 @@
+#pragma once
+
+// Helpers shared by the lab7_test_* programs.
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace lab5::test {
+
+inline int failures = 0;
+
+inline void check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+// Deletes a SQLite database together with its WAL and shared-memory files.
+inline void remove_db(const std::string& path) {
+    std::error_code ec;
+    for (const char* suffix : {"", "-wal", "-shm"}) std::filesystem::remove(path + suffix, ec);
+}
+
+// Prints "ok" and returns the process exit code.
+inline int finish() {
+    if (failures == 0) std::printf("ok\n");
+    return failures == 0 ? 0 : 1;
+}
+
+}  // namespace lab5::test
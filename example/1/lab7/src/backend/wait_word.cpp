@@ -0,0 +1,47 @@
+#include "wait_word.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+#endif
+
+namespace lab5 {
+
+std::uint32_t WaitWord::prepare_wait() {
+    sleepers_.fetch_add(1);
+    return word_.load();
+}
+
+void WaitWord::cancel_wait() { sleepers_.fetch_sub(1); }
+
+bool WaitWord::notify() {
+    // Orders the caller's state change before the sleepers_ check; pairs with prepare_wait().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0) return false;
+    word_.fetch_add(1);
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+    }
+    cv_.notify_all();
+#endif
+    return true;
+}
+
+void WaitWord::wait(std::uint32_t ticket) {
+#ifdef __linux__
+    // Returns at once if word_ moved past ticket; spurious returns are fine for callers.
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word_), FUTEX_WAIT_PRIVATE, ticket, nullptr, nullptr, 0);
+#else
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [&] { return word_.load() != ticket; });
+#endif
+    sleepers_.fetch_sub(1);
+}
+
+}  // namespace lab5
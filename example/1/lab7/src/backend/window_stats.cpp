@@ -0,0 +1,84 @@
+#include "window_stats.h"
+
+#include <istream>
+#include <ostream>
+
+#include "aggregate.h"
+
+namespace lab5 {
+
+void SlidingWindow::add(std::int64_t epoch_ms, double value) {
+    points_.push_back({epoch_ms, value});
+    sum_ += value;
+    while (!min_q_.empty() && min_q_.back().value >= value) min_q_.pop_back();
+    min_q_.push_back({epoch_ms, value});
+    while (!max_q_.empty() && max_q_.back().value <= value) max_q_.pop_back();
+    max_q_.push_back({epoch_ms, value});
+    expire(epoch_ms);
+}
+
+void SlidingWindow::expire(std::int64_t now_ms) {
+    const std::int64_t cutoff = now_ms - span_ms_;
+    while (!points_.empty() && points_.front().epoch_ms <= cutoff) {
+        sum_ -= points_.front().value;
+        points_.pop_front();
+    }
+    // Drop accumulated rounding error whenever the window runs empty.
+    if (points_.empty()) sum_ = 0.0;
+    while (!min_q_.empty() && min_q_.front().epoch_ms <= cutoff) min_q_.pop_front();
+    while (!max_q_.empty() && max_q_.front().epoch_ms <= cutoff) max_q_.pop_front();
+}
+
+void SlidingWindow::save(std::ostream& out) const {
+    out << points_.size() << '\n';
+    for (const auto& p : points_) out << p.epoch_ms << ' ' << p.value << '\n';
+}
+
+WindowSet::WindowSet(const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        const auto span = parse_step(name);
+        if (!span) continue;
+        names_.push_back(name);
+        windows_.emplace_back(*span);
+    }
+}
+
+void WindowSet::add(std::int64_t epoch_ms, double value) {
+    for (auto& w : windows_) w.add(epoch_ms, value);
+}
+
+void WindowSet::snapshot(std::vector<WindowSnapshot>& out) const {
+    out.resize(windows_.size());
+    for (std::size_t i = 0; i < windows_.size(); ++i) {
+        const auto& w = windows_[i];
+        out[i] = WindowSnapshot{names_[i], w.count(), w.avg(), w.min(), w.max()};
+    }
+}
+
+void WindowSet::save(std::ostream& out) const {
+    const SlidingWindow* longest = nullptr;
+    for (const auto& w : windows_) {
+        if (!longest || w.span_ms() > longest->span_ms()) longest = &w;
+    }
+    out << "windows ";
+    if (longest) longest->save(out);
+    else out << "0\n";
+}
+
+bool WindowSet::load(std::istream& in) {
+    std::string tag;
+    std::size_t n = 0;
+    if (!(in >> tag >> n) || tag != "windows") return false;
+    std::vector<SlidingWindow> loaded;
+    for (const auto& w : windows_) loaded.emplace_back(w.span_ms());
+    for (std::size_t i = 0; i < n; ++i) {
+        std::int64_t epoch_ms = 0;
+        double value = 0.0;
+        if (!(in >> epoch_ms >> value)) return false;
+        for (auto& w : loaded) w.add(epoch_ms, value);
+    }
+    windows_ = std::move(loaded);
+    return true;
+}
+
+}  // namespace lab5
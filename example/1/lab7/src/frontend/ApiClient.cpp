@@ -28,7 +28,7 @@ void ApiClient::fetchCurrent() {
     connect(reply, &QNetworkReply::finished, this, [this, reply]() { handleReply(reply, true); });
 }
 
-void ApiClient::fetchStats(const QString& bucket, qint64 startMs, qint64 endMs) {
+void ApiClient::fetchStats(const QString& bucket, qint64 startMs, qint64 endMs, int maxPoints) {
     if (!baseUrl_.isValid()) return;
     QUrl url = baseUrl_;
     url.setPath("/api/stats");
@@ -36,6 +36,7 @@ void ApiClient::fetchStats(const QString& bucket, qint64 startMs, qint64 endMs)
     q.addQueryItem("bucket", bucket);
     q.addQueryItem("start", QString::number(startMs));
     q.addQueryItem("end", QString::number(endMs));
+    if (maxPoints > 0) q.addQueryItem("max_points", QString::number(maxPoints));
     url.setQuery(q);
     QNetworkRequest req(url);
     auto reply = mgr_->get(req);
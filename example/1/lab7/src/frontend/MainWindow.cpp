@@ -2,6 +2,8 @@
 
 #include "ApiClient.h"
 
+#include <algorithm>
+
 #include <QComboBox>
 #include <QCursor>
 #include <QDateTime>
@@ -68,7 +70,11 @@ void MainWindow::setupUi() {
     rangeCombo_->addItem("30 дней", QVariant::fromValue<qint64>(30LL * 24 * 60 * 60 * 1000));
 
     bucketCombo_ = new QComboBox(this);
+    bucketCombo_->addItem("Авто", "auto");
     bucketCombo_->addItem("Сырые", "raw");
+    bucketCombo_->addItem("1 мин", "1m");
+    bucketCombo_->addItem("5 мин", "5m");
+    bucketCombo_->addItem("15 мин", "15m");
     bucketCombo_->addItem("Почасовые", "hourly");
     bucketCombo_->addItem("Дневные", "daily");
 
@@ -177,7 +183,9 @@ void MainWindow::requestData() {
     const auto span = rangeCombo_->currentData().toLongLong();
     const auto start = now - span;
     const auto bucket = bucketCombo_->currentData().toString();
-    api_->fetchStats(bucket, start, now);
+    // One point per pixel of the plot is enough; the server picks the rollup tier.
+    const int maxPoints = bucket == QLatin1String("auto") ? std::max(200, plot_->width()) : 0;
+    api_->fetchStats(bucket, start, now, maxPoints);
 }
 
 qint64 MainWindow::nowMs() const {
@@ -12,7 +12,8 @@
 #include <fcntl.h>
 #include <ctime>
 #include <chrono>
-#include <format>
+#include <cstring>
+#include <limits>
 
 #define LOG_FILE "app.log"
 
@@ -39,23 +40,40 @@ void logMessage(const std::string &message)
   mtx.unlock();
 }
 
-std::string getCurrentTimestamp()
+// Пишет "YYYY-MM-DD HH:MM:SS.mmm" в out (не меньше 24 байт) и возвращает длину.
+// Дата и время кэшируются на текущую секунду, форматируются только миллисекунды.
+size_t formatCurrentTimestamp(char *out)
 {
+  thread_local long long cached_sec = -1;
+  thread_local char cached_prefix[20] = {};
+
   const auto now_time = std::chrono::system_clock::now();
-  std::time_t tt = std::chrono::system_clock::to_time_t(now_time);
-  std::tm tm = *std::localtime(&tt);
-
-  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now_time.time_since_epoch()) % 1000;
-
-  return std::format(
-      "{:04}-{:02}-{:02} {:02}:{:02}:{:02}.{:03}",
-      tm.tm_year + 1900,
-      tm.tm_mon + 1,
-      tm.tm_mday,
-      tm.tm_hour,
-      tm.tm_min,
-      tm.tm_sec,
-      ms.count());
+  const long long epoch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now_time.time_since_epoch()).count();
+  const long long sec = epoch_ms / 1000;
+  const long long ms = epoch_ms % 1000;
+
+  if (sec != cached_sec)
+  {
+    std::time_t tt = static_cast<std::time_t>(sec);
+    std::tm tm{};
+    localtime_r(&tt, &tm);
+    std::strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S", &tm);
+    cached_sec = sec;
+  }
+
+  std::memcpy(out, cached_prefix, 19);
+  out[19] = '.';
+  out[20] = static_cast<char>('0' + ms / 100);
+  out[21] = static_cast<char>('0' + ms / 10 % 10);
+  out[22] = static_cast<char>('0' + ms % 10);
+  out[23] = '\0';
+  return 23;
+}
+
+std::string getCurrentTimestamp()
+{
+  char buf[24];
+  return std::string(buf, formatCurrentTimestamp(buf));
 }
 
 void *timer_increment(void *)
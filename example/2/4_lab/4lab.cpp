@@ -1,13 +1,14 @@
 #include "my_serial.hpp"
+#include "../common/packet_check.hpp"
+#include "../common/rollup.hpp"
 
-#include <sstream>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <ctime>
 #include <chrono>
-#include <iomanip>
 #include <cstdio>
 
 #if !defined(WIN32)
@@ -45,14 +46,11 @@ std::tm local_tm(std::time_t t)
     return tm;
 }
 
-double compute_avg(const std::vector<double> &vals)
+void print_rollup(const char *title, const cplib::Rollup &stats)
 {
-    if (vals.empty())
-        return 0.0;
-    double sum = 0.0;
-    for (double v : vals)
-        sum += v;
-    return sum / vals.size();
+    std::cout << title << ": " << stats.Count() << " values, avg " << stats.Mean()
+              << ", min " << stats.Min() << ", max " << stats.Max()
+              << ", sd " << stats.Stddev() << "\n";
 }
 
 std::size_t count_lines(const std::string &file)
@@ -105,43 +103,25 @@ void append_line(const std::string &file,
     f << msg << "\n";
 }
 
-std::string hash_of_string(const std::string &s)
+int main(int argc, char **argv)
 {
-    std::stringstream hex_stream;
-
-    for (char c : s)
+    if (argc < 2)
     {
-        hex_stream << std::hex << std::setw(2) << std::setfill('0')
-                   << static_cast<int>(static_cast<unsigned char>(c));
+        std::cout << "Usage: [progname] [port] [baudrate=115200]\n";
+        return -1;
     }
 
-    std::string result = hex_stream.str();
-    for (char &c : result)
+    // Любая скорость, которую умеет драйвер: 921600 и выше для USB-serial
+    cplib::SerialPort::Parameters params(argc > 2 ? argv[2] : "115200");
+    if (!params.IsValid())
     {
-        c = std::toupper(static_cast<unsigned char>(c));
-    }
-
-    return result;
-}
-
-bool parse_packet(const std::string &s, double &value, std::string &checksum)
-{
-    std::stringstream ss(s);
-
-    ss >> value >> checksum;
-
-    return !ss.fail();
-}
-
-int main(int argc, char **argv)
-{
-    if (argc < 2)
-    {
-        std::cout << "Usage: [progname] [port]\n";
+        std::cout << "Invalid baudrate\n";
         return -1;
     }
+    params.low_latency = true;
 
-    cplib::SerialPort smport(argv[1], cplib::SerialPort::BAUDRATE_115200);
+    cplib::SerialPort smport;
+    smport.Open(argv[1], params);
     if (!smport.IsOpen())
     {
         std::cout << "Failed to open port\n";
@@ -150,25 +130,55 @@ int main(int argc, char **argv)
 
     smport.SetTimeout(1.0);
 
-    std::vector<double> hour_vals;
-    std::vector<double> day_vals;
+    cplib::Rollup hour_stats;
+    cplib::Rollup day_stats;
     std::vector<std::pair<std::time_t, double>> measurement_buffer;
 
     std::tm last_tm = local_tm(now_ts());
     int last_hour = last_tm.tm_hour;
     int last_mday = last_tm.tm_mday;
 
-    std::string line;
+    // Указывает во внутренний буфер порта, действительна до следующего ReadLine
+    std::string_view line;
 
     for (;;)
     {
-        smport >> line;
+        smport.ReadLine(line);
         if (!line.empty())
         {
+            // Сначала закрываем прошедший час/сутки, чтобы новый отсчёт попал в новый интервал
+            std::tm cur_tm = local_tm(now_ts());
+
+            if (cur_tm.tm_hour != last_hour)
+            {
+                append_line(
+                    LOG_HOURLY,
+                    std::to_string(now_ts()) + " " +
+                        std::to_string(hour_stats.Mean()),
+                    1);
+
+                print_rollup("Hour", hour_stats);
+                hour_stats.Reset();
+                last_hour = cur_tm.tm_hour;
+            }
+
+            if (cur_tm.tm_mday != last_mday)
+            {
+                append_line(
+                    LOG_DAILY,
+                    std::to_string(now_ts()) + " " +
+                        std::to_string(day_stats.Mean()),
+                    2);
+
+                print_rollup("Day", day_stats);
+                day_stats.Reset();
+                last_mday = cur_tm.tm_mday;
+            }
+
             double value;
-            std::string checksum;
 
-            if (parse_packet(line, value, checksum))
+            // Контрольная сумма сверяется с байтами значения, как они пришли
+            if (cplib::check_packet(line, value))
             {
                 bool value_ok = (value >= -60.0 && value <= 60.0);
 
@@ -180,55 +190,27 @@ int main(int argc, char **argv)
 
                 if (value_ok)
                 {
-                    std::string calc = hash_of_string(std::to_string(value));
-                    if (calc == checksum)
-                    {
-                        std::cout << "New value -> " << value << std::endl;
-                        std::time_t ts = now_ts();
+                    std::cout << "New value -> " << value << std::endl;
+                    std::time_t ts = now_ts();
 
-                        measurement_buffer.emplace_back(ts, value);
+                    measurement_buffer.emplace_back(ts, value);
+                    hour_stats.Add(value);
+                    day_stats.Add(value);
 
-                        if (measurement_buffer.size() >= 10)
+                    if (measurement_buffer.size() >= 10)
+                    {
+                        for (const auto &measurement : measurement_buffer)
                         {
-                            for (const auto &measurement : measurement_buffer)
-                            {
-                                append_line(
-                                    LOG_MEASURE,
-                                    std::to_string(measurement.first) + " " +
-                                        std::to_string(measurement.second),
-                                    0);
-                            }
-                            measurement_buffer.clear();
-
-                            hour_vals.push_back(value);
-                            day_vals.push_back(value);
+                            append_line(
+                                LOG_MEASURE,
+                                std::to_string(measurement.first) + " " +
+                                    std::to_string(measurement.second),
+                                0);
                         }
+                        measurement_buffer.clear();
                     }
                 }
             }
-
-            std::tm cur_tm = local_tm(now_ts());
-
-            if (cur_tm.tm_hour != last_hour)
-            {
-                append_line(
-                    LOG_HOURLY,
-                    std::to_string(now_ts()) + " " +
-                        std::to_string(compute_avg(hour_vals)),
-                    1);
-
-                hour_vals.clear();
-                last_hour = cur_tm.tm_hour;
-            }
-
-            if (cur_tm.tm_mday != last_mday)
-            {
-                append_line(
-                    LOG_DAILY,
-                    std::to_string(now_ts()) + " " +
-                        std::to_string(compute_avg(day_vals)),
-                    2);
-            }
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+// Бенчмарк чтения пакетов из порта: старый smport >> line против ReadLine.
+// Порт эмулируется псевдотерминалом (pty), писатель выдаёт пакеты формата 4lab
+// ("значение HEX\r\n") кусками случайной длины со скоростью, соответствующей
+// заданному baud (10 бит на байт), или без ограничения (baud = 0).
+// Сборка: g++ -std=c++17 -O2 bench_readline.cpp -o bench_readline -pthread
+// Запуск: ./bench_readline [секунд на прогон = 2]
+
+#include "my_serial.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std::chrono;
+
+std::string hash_of_string(const std::string &s)
+{
+    std::stringstream hex_stream;
+    for (char c : s)
+        hex_stream << std::hex << std::uppercase << std::setw(2) << std::setfill('0')
+                   << static_cast<int>(static_cast<unsigned char>(c));
+    return hex_stream.str();
+}
+
+bool valid_packet(std::string_view s)
+{
+    std::stringstream ss{std::string(s)};
+    double value;
+    std::string checksum;
+    ss >> value >> checksum;
+    return !ss.fail() && hash_of_string(std::to_string(value)) == checksum;
+}
+
+double thread_cpu_seconds()
+{
+    rusage ru{};
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+struct Result
+{
+    std::size_t sent = 0;
+    std::size_t valid = 0;
+    std::size_t reads = 0;
+    double seconds = 0.0;
+    double cpu = 0.0;
+};
+
+// Пишет пакеты в master в течение seconds секунд; baud = 0 - без паузы.
+std::size_t write_packets(int master, long baud, double seconds, std::atomic<bool> &done)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> temp(-20.0, 40.0);
+    std::uniform_int_distribution<int> chunk(1, 64);
+
+    std::string pending;
+    std::size_t sent = 0;
+    std::size_t bytes = 0;
+    const auto start = steady_clock::now();
+    while (duration<double>(steady_clock::now() - start).count() < seconds)
+    {
+        while (pending.size() < 256)
+        {
+            // Значение с 2 знаками, как у симулятора; контрольная сумма от std::to_string
+            double v = std::round(temp(rng) * 100.0) / 100.0;
+            std::string text = std::to_string(v);
+            pending += text + " " + hash_of_string(text) + "\r\n";
+            ++sent;
+        }
+        std::size_t n = std::min<std::size_t>(chunk(rng), pending.size());
+        ssize_t w = write(master, pending.data(), n);
+        if (w > 0)
+        {
+            pending.erase(0, static_cast<std::size_t>(w));
+            bytes += static_cast<std::size_t>(w);
+        }
+        if (baud > 0)
+        {
+            auto due = start + duration_cast<steady_clock::duration>(duration<double>(bytes * 10.0 / baud));
+            std::this_thread::sleep_until(due);
+        }
+    }
+    // Пакеты, оставшиеся в pending, не отправлены
+    sent -= std::count(pending.begin(), pending.end(), '\n');
+    done = true;
+    return sent;
+}
+
+Result run(bool use_readline, long baud, double seconds)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    cplib::SerialPort port(ptsname(master), cplib::SerialPort::BAUDRATE_115200);
+    port.SetTimeout(0.1);
+
+    Result r;
+    std::atomic<bool> done{false};
+    std::thread writer([&] { r.sent = write_packets(master, baud, seconds, done); });
+
+    const double cpu0 = thread_cpu_seconds();
+    const auto start = steady_clock::now();
+    std::string line;
+    std::string_view view;
+    for (;;)
+    {
+        if (use_readline)
+        {
+            port.ReadLine(view);
+            ++r.reads;
+            if (!view.empty())
+                r.valid += valid_packet(view);
+            else if (done)
+                break;
+        }
+        else
+        {
+            port >> line;
+            ++r.reads;
+            if (!line.empty())
+                r.valid += valid_packet(line);
+            else if (done)
+                break;
+        }
+    }
+    r.seconds = duration<double>(steady_clock::now() - start).count();
+    r.cpu = thread_cpu_seconds() - cpu0;
+    writer.join();
+    close(master);
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    std::cout << std::left << std::setw(10) << "baud" << std::setw(10) << "reader" << std::right
+              << std::setw(10) << "sent" << std::setw(10) << "valid" << std::setw(9) << "lost%"
+              << std::setw(12) << "pkt/s" << std::setw(10) << "calls" << std::setw(10) << "cpu,s" << "\n";
+    for (long baud : {115200L, 230400L, 460800L, 921600L, 0L})
+    {
+        for (bool use_readline : {false, true})
+        {
+            Result r = run(use_readline, baud, seconds);
+            double lost = r.sent ? 100.0 * (double)(r.sent - std::min(r.sent, r.valid)) / r.sent : 0.0;
+            std::cout << std::left << std::setw(10) << (baud ? std::to_string(baud) : "max")
+                      << std::setw(10) << (use_readline ? "ReadLine" : ">>") << std::right
+                      << std::setw(10) << r.sent << std::setw(10) << r.valid
+                      << std::setw(9) << std::fixed << std::setprecision(2) << lost
+                      << std::setw(12) << std::setprecision(0) << r.valid / r.seconds
+                      << std::setw(10) << r.reads << std::setw(10) << std::setprecision(3) << r.cpu << "\n";
+        }
+    }
+    return 0;
+}
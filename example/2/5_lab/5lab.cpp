@@ -1,16 +1,21 @@
 #include "my_serial.hpp"
+#include "../common/packet_check.hpp"
+#include "../common/rollup.hpp"
 #include "sqlite3.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <ctime>
 #include <chrono>
-#include <iomanip>
 #include <cstdio>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <csignal>
 #include <map>
 #include <unordered_map>
 #ifdef _WIN32
@@ -18,6 +23,7 @@
 #include <ws2tcpip.h>
 #pragma comment(lib, "Ws2_32.lib")
 #else
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -33,9 +39,38 @@
 #endif
 
 std::mutex db_mutex;
-double last_temperature = 0.0;
+std::atomic<double> last_temperature{0.0};
 sqlite3 *db = nullptr;
 
+// Принятый отсчёт; время - момент прихода строки из порта
+struct Sample
+{
+    double value;
+    std::time_t ts;
+};
+
+// Очередь от чтения порта к писателю в БД: чтение никогда не ждёт диска
+std::mutex queue_mutex;
+std::condition_variable queue_cv;
+std::vector<Sample> sample_queue;
+bool reader_done = false;
+std::atomic<bool> running{true};
+
+// Писатель сбрасывает очередь одной транзакцией, когда набралось
+// WRITE_BATCH отсчётов или прошло WRITE_INTERVAL
+const size_t WRITE_BATCH = 256;
+const std::chrono::milliseconds WRITE_INTERVAL(200);
+
+// Подготовленные один раз запросы писателя
+struct DbWriter
+{
+    sqlite3_stmt *measurements = nullptr;
+    sqlite3_stmt *hourly = nullptr;
+    sqlite3_stmt *daily = nullptr;
+    sqlite3_stmt *begin = nullptr;
+    sqlite3_stmt *commit = nullptr;
+};
+
 std::time_t now_ts()
 {
     return std::time(nullptr);
@@ -52,14 +87,11 @@ std::tm local_tm(std::time_t t)
     return tm;
 }
 
-double compute_avg(const std::vector<double> &vals)
+void print_rollup(const char *title, const cplib::Rollup &stats)
 {
-    if (vals.empty())
-        return 0.0;
-    double sum = 0.0;
-    for (double v : vals)
-        sum += v;
-    return sum / vals.size();
+    std::cout << title << ": " << stats.Count() << " values, avg " << stats.Mean()
+              << ", min " << stats.Min() << ", max " << stats.Max()
+              << ", sd " << stats.Stddev() << "\n";
 }
 
 void initialize_database()
@@ -96,62 +128,65 @@ void initialize_database()
     }
 }
 
-void write_value(const std::string &table_name, double value, std::time_t timestamp)
+sqlite3_stmt *prepare(const std::string &sql)
 {
-    if (db == nullptr)
-    {
-        std::cerr << "Database not opened!" << std::endl;
-        return;
-    }
-
-    std::string sql = "INSERT INTO " + table_name + " (value, timestamp) VALUES (?, ?);";
-
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
-    if (rc != SQLITE_OK)
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
     {
         std::cerr << "SQL prepare error: " << sqlite3_errmsg(db) << std::endl;
-        return;
+        return nullptr;
     }
+    return stmt;
+}
 
-    sqlite3_bind_double(stmt, 1, value);
-    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(timestamp));
-
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
+bool open_writer(DbWriter &w)
+{
+    if (db == nullptr)
     {
-        std::cerr << "SQL step error: " << sqlite3_errmsg(db) << std::endl;
+        std::cerr << "Database not opened!" << std::endl;
+        return false;
     }
 
-    sqlite3_finalize(stmt);
+    auto insert = [](const std::string &table_name)
+    {
+        return prepare("INSERT INTO " + table_name + " (value, timestamp) VALUES (?, ?);");
+    };
+    w.measurements = insert("measurements");
+    w.hourly = insert("hourly_measurements");
+    w.daily = insert("daily_measurements");
+    w.begin = prepare("BEGIN;");
+    w.commit = prepare("COMMIT;");
+    return w.measurements && w.hourly && w.daily && w.begin && w.commit;
 }
 
-std::string hash_of_string(const std::string &s)
+void close_writer(DbWriter &w)
 {
-    std::stringstream hex_stream;
-
-    for (char c : s)
-    {
-        hex_stream << std::hex << std::setw(2) << std::setfill('0')
-                   << static_cast<int>(static_cast<unsigned char>(c));
-    }
+    // sqlite3_finalize(nullptr) ничего не делает
+    sqlite3_finalize(w.measurements);
+    sqlite3_finalize(w.hourly);
+    sqlite3_finalize(w.daily);
+    sqlite3_finalize(w.begin);
+    sqlite3_finalize(w.commit);
+    w = DbWriter();
+}
 
-    std::string result = hex_stream.str();
-    for (char &c : result)
+bool run_statement(sqlite3_stmt *stmt)
+{
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE)
     {
-        c = std::toupper(static_cast<unsigned char>(c));
+        std::cerr << "SQL step error: " << sqlite3_errmsg(db) << std::endl;
+        return false;
     }
-
-    return result;
+    return true;
 }
 
-bool parse_packet(const std::string &s, double &value, std::string &checksum)
+void write_value(sqlite3_stmt *stmt, double value, std::time_t timestamp)
 {
-    std::stringstream ss(s);
-
-    ss >> value >> checksum;
-
-    return !ss.fail();
+    sqlite3_bind_double(stmt, 1, value);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(timestamp));
+    run_statement(stmt);
 }
 
 std::string http_response(const std::string &body)
@@ -243,6 +278,21 @@ std::string values_to_json(
 }
 
 
+// Ждёт данных на сокете не дольше timeout_ms; false по таймауту, ошибке или сигналу
+template <typename Socket>
+bool wait_readable(Socket fd, long timeout_ms)
+{
+    fd_set ready;
+    FD_ZERO(&ready);
+    FD_SET(fd, &ready);
+    timeval tv{};
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    return select(static_cast<int>(fd) + 1, &ready, nullptr, nullptr, &tv) > 0;
+}
+
+// Работает, пока running: accept ждёт с таймаутом, чтобы main мог остановить
+// и дождаться поток до закрытия БД
 void http_server()
 {
     if (!net_init())
@@ -258,12 +308,25 @@ void http_server()
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(8080);
 
+#ifndef _WIN32
+    // Перезапуск сразу после остановки: порт ещё занят соединениями в TIME_WAIT
+    int reuse = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
     bind(server_fd, (sockaddr *)&addr, sizeof(addr));
     listen(server_fd, 5);
     std::cout << "HTTP server listening on port 8080\n";
-    while (true)
+    while (running)
     {
-        int client = accept(server_fd, nullptr, nullptr);
+        if (!wait_readable(server_fd, 200))
+            continue;
+        auto client = accept(server_fd, nullptr, nullptr);
+        // Молчащий клиент не должен держать поток при остановке
+        if (!wait_readable(client, 1000))
+        {
+            socket_close(client);
+            continue;
+        }
         char buffer[1024]{};
         recv(client, buffer, sizeof(buffer) - 1, 0);
         std::string request(buffer);
@@ -309,7 +372,7 @@ void http_server()
 
         if (request.find("GET /current") != std::string::npos)
         {
-            body = "{ \"temperature\": " + std::to_string(last_temperature) + " }";
+            body = "{ \"temperature\": " + std::to_string(last_temperature.load()) + " }";
         }
         else if (request.find("GET /stats") != std::string::npos)
         {
@@ -341,101 +404,161 @@ void http_server()
         send(client, resp.c_str(), resp.size(), 0);
         socket_close(client);
     }
+
+    socket_close(server_fd);
+    net_cleanup();
 }
 
-int main(int argc, char **argv)
+void on_signal(int)
 {
-    if (argc < 2)
-    {
-        std::cout << "Usage: [progname] [port]\n";
-        return -1;
-    }
-
-    cplib::SerialPort smport(argv[1], cplib::SerialPort::BAUDRATE_115200);
-    if (!smport.IsOpen())
-    {
-        std::cout << "Failed to open port\n";
-        return -2;
-    }
-    initialize_database();
-    std::thread(http_server).detach();
+    running = false;
+}
 
-    smport.SetTimeout(1.0);
+// Поток записи: забирает очередь целиком, считает часовые и суточные средние
+// по времени прихода отсчётов и пишет всё одной транзакцией
+void db_writer()
+{
+    DbWriter w;
+    if (!open_writer(w))
+        std::cerr << "Measurements will not be stored" << std::endl;
 
-    std::vector<double> hour_vals;
-    std::vector<double> day_vals;
-    std::vector<double> measurement_buffer;
+    cplib::Rollup hour_stats;
+    cplib::Rollup day_stats;
 
     std::tm last_tm = local_tm(now_ts());
     int last_hour = last_tm.tm_hour;
     int last_mday = last_tm.tm_mday;
 
-    std::string line;
-    std::cout << "Started!" << std::endl;
-    for (;;)
+    std::vector<Sample> batch;
+    bool done = false;
+    while (!done)
     {
-        smport >> line;
-        if (!line.empty())
         {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait_for(lock, WRITE_INTERVAL, []
+                              { return sample_queue.size() >= WRITE_BATCH || reader_done; });
+            batch.swap(sample_queue);
+            done = reader_done;
+        }
+        if (batch.empty() || !w.begin)
+        {
+            batch.clear();
+            continue;
+        }
 
-            double value;
-            std::string checksum;
-
-            if (parse_packet(line, value, checksum))
+        std::lock_guard<std::mutex> lock(db_mutex);
+        run_statement(w.begin);
+        std::time_t tm_ts = 0;
+        std::tm cur_tm{};
+        for (const Sample &sample : batch)
+        {
+            if (sample.ts != tm_ts)
             {
-
-                if (value >= -60.0 && value <= 60.0 && (measurement_buffer.size() > 0 && measurement_buffer.back() - value < 1 || true))
-                {
-                    std::string calc = hash_of_string(std::to_string(value));
-                    if (calc == checksum)
-                    {
-                        std::time_t ts = now_ts();
-
-                        measurement_buffer.push_back(value);
-                        last_temperature = value;
-                        std::cout << "Received valid measurement: " << value << " at " << ts << std::endl;
-                        write_value("measurements", value, ts);
-                        if (measurement_buffer.size() >= 5)
-                        {   // На случай если надо использовать буффер=)
-                            // for (const auto &measurement : measurement_buffer)
-                            // {
-                            //     write_value("measurements", value, ts);
-                            // }
-                            measurement_buffer.clear();
-                        }
-                        hour_vals.push_back(value);
-                        day_vals.push_back(value);
-                    }
-                }
+                cur_tm = local_tm(sample.ts);
+                tm_ts = sample.ts;
             }
-            std::time_t current_time = now_ts();
-            std::tm cur_tm = local_tm(now_ts());
 
             if (cur_tm.tm_hour != last_hour)
             {
-                double avg_hour = compute_avg(hour_vals);
-                std::time_t hour_ts = current_time - (cur_tm.tm_min * 60 + cur_tm.tm_sec);
-                write_value("hourly_measurements", avg_hour, hour_ts);
-                hour_vals.clear();
+                std::time_t hour_ts = sample.ts - (cur_tm.tm_min * 60 + cur_tm.tm_sec);
+                write_value(w.hourly, hour_stats.Mean(), hour_ts);
+                print_rollup("Hour", hour_stats);
+                hour_stats.Reset();
                 last_hour = cur_tm.tm_hour;
             }
 
             if (cur_tm.tm_mday != last_mday)
             {
-                double avg_day = compute_avg(day_vals);
                 std::tm day_start = cur_tm;
                 day_start.tm_hour = 0;
                 day_start.tm_min = 0;
                 day_start.tm_sec = 0;
                 std::time_t day_ts = std::mktime(&day_start);
 
-                write_value("daily_measurements", avg_day, day_ts);
-                day_vals.clear();
+                write_value(w.daily, day_stats.Mean(), day_ts);
+                print_rollup("Day", day_stats);
+                day_stats.Reset();
                 last_mday = cur_tm.tm_mday;
             }
+
+            write_value(w.measurements, sample.value, sample.ts);
+            hour_stats.Add(sample.value);
+            day_stats.Add(sample.value);
         }
+        run_statement(w.commit);
+
+        std::cout << "Stored " << batch.size() << " measurements, last " << batch.back().value
+                  << " at " << batch.back().ts << "\n";
+        batch.clear();
     }
 
+    close_writer(w);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: [progname] [port] [baudrate=115200]\n";
+        return -1;
+    }
+
+    // Любая скорость, которую умеет драйвер: 921600 и выше для USB-serial
+    cplib::SerialPort::Parameters params(argc > 2 ? argv[2] : "115200");
+    if (!params.IsValid())
+    {
+        std::cout << "Invalid baudrate\n";
+        return -1;
+    }
+    params.low_latency = true;
+
+    cplib::SerialPort smport;
+    smport.Open(argv[1], params);
+    if (!smport.IsOpen())
+    {
+        std::cout << "Failed to open port\n";
+        return -2;
+    }
+    initialize_database();
+    std::thread http(http_server);
+
+    smport.SetTimeout(1.0);
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::thread writer(db_writer);
+
+    // Указывает во внутренний буфер порта, действительна до следующего ReadLine
+    std::string_view line;
+    std::cout << "Started!" << std::endl;
+    while (running)
+    {
+        smport.ReadLine(line);
+        if (line.empty())
+            continue;
+        std::time_t ts = now_ts();
+
+        double value;
+        // Контрольная сумма сверяется с байтами значения, как они пришли
+        if (!cplib::check_packet(line, value) || value < -60.0 || value > 60.0)
+            continue;
+        last_temperature = value;
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        sample_queue.push_back({value, ts});
+        if (sample_queue.size() == WRITE_BATCH)
+            queue_cv.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        reader_done = true;
+    }
+    queue_cv.notify_one();
+    writer.join();
+    http.join();
+
+    std::lock_guard<std::mutex> lock(db_mutex);
     sqlite3_close(db);
     return 0;
 }
\ No newline at end of file
@@ -12,14 +12,32 @@
 #define MY_PORT_HANDLE int32_t
 #define MY_PORT_SETTINGS termios
 #define MY_INVALID_HANDLE -1
+#if defined(__linux__)
+#include <linux/serial.h> // serial_struct, ASYNC_LOW_LATENCY
+#if defined(TCGETS2)
+#define MY_PORT_CUSTOM_BAUD // произвольная скорость через termios2 + BOTHER
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#ifndef IBSHIFT
+#define IBSHIFT 16
+#endif
+#endif
+#elif defined(__APPLE__)
+#include <IOKit/serial/ioss.h> // IOSSIOSPEED, IOSSDATALAT
+#define MY_PORT_CUSTOM_BAUD // произвольная скорость через IOSSIOSPEED
+#endif
 #endif
 
-#include <string>  // std::string
-#include <cstring> // strcmp()
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <vector>      // буфер ReadLine
+#include <cstring>     // strcmp(), memchr()
 #include <cstdint>
 
 #define MY_PORT_READ_BUF 1500
 #define MY_PORT_WRITE_BUF 1500
+#define MY_PORT_LINE_BUF 4096
 #define SERIAL_PORT_DEFAULT_TIMEOUT 1.0
 
 namespace cplib
@@ -27,24 +45,24 @@ namespace cplib
 	class SerialPort
 	{
 	public:
-		// Скорости
-		enum BaudRate
+		// Скорости, бит/с. Windows (DCB::BaudRate) принимает число как есть,
+		// в POSIX оно переводится в константу Bxxx, а любое другое положительное
+		// значение ставится как нестандартная скорость (см. MY_PORT_CUSTOM_BAUD)
+		enum BaudRate : int32_t
 		{
-#if defined(WIN32)
-			BAUDRATE_4800 = CBR_4800,	  // 4800 bps
-			BAUDRATE_9600 = CBR_9600,	  // 9600 bps
-			BAUDRATE_19200 = CBR_19200,	  // 19200 bps
-			BAUDRATE_38400 = CBR_38400,	  // 38400 bps
-			BAUDRATE_57600 = CBR_57600,	  // 57600 bps
-			BAUDRATE_115200 = CBR_115200, // 115200 bps
-#else
-			BAUDRATE_4800 = B4800,	   // 4800 bps
-			BAUDRATE_9600 = B9600,	   // 9600 bps
-			BAUDRATE_19200 = B19200,   // 19200 bps
-			BAUDRATE_38400 = B38400,   // 38400 bps
-			BAUDRATE_57600 = B57600,   // 57600 bps
-			BAUDRATE_115200 = B115200, // 115200 bps
-#endif
+			BAUDRATE_4800 = 4800,
+			BAUDRATE_9600 = 9600,
+			BAUDRATE_19200 = 19200,
+			BAUDRATE_38400 = 38400,
+			BAUDRATE_57600 = 57600,
+			BAUDRATE_115200 = 115200,
+			BAUDRATE_230400 = 230400,
+			BAUDRATE_460800 = 460800,
+			BAUDRATE_921600 = 921600,
+			BAUDRATE_1000000 = 1000000,
+			BAUDRATE_2000000 = 2000000,
+			BAUDRATE_3000000 = 3000000,
+			BAUDRATE_4000000 = 4000000,
 			BAUDRATE_INVALID = -1
 		};
 
@@ -127,44 +145,26 @@ namespace cplib
 				Defaults();
 				baud_rate = BaudrateFromString(speed);
 			}
-			// Строка --> baudrate
+			// Строка --> baudrate: любое положительное число бит/с
 			static BaudRate BaudrateFromString(const char *baud)
 			{
-				if (!strcmp(baud, "4800"))
-					return BAUDRATE_4800;
-				if (!strcmp(baud, "9600"))
-					return BAUDRATE_9600;
-				if (!strcmp(baud, "19200"))
-					return BAUDRATE_19200;
-				if (!strcmp(baud, "38400"))
-					return BAUDRATE_38400;
-				if (!strcmp(baud, "57600"))
-					return BAUDRATE_57600;
-				if (!strcmp(baud, "115200"))
-					return BAUDRATE_115200;
-				return BAUDRATE_INVALID;
-			}
-			// baudrate --> строка
-			static const char *StringFromBaudrate(BaudRate baud)
-			{
-				switch (baud)
+				int64_t value = 0;
+				for (const char *p = baud; *p; ++p)
 				{
-				case BAUDRATE_4800:
-					return "4800";
-				case BAUDRATE_9600:
-					return "9600";
-				case BAUDRATE_19200:
-					return "19200";
-				case BAUDRATE_38400:
-					return "38400";
-				case BAUDRATE_57600:
-					return "57600";
-				case BAUDRATE_115200:
-					return "115200";
-				default:
-					return NULL;
+					if (*p < '0' || *p > '9' || value > INT32_MAX / 10)
+						return BAUDRATE_INVALID;
+					value = value * 10 + (*p - '0');
 				}
-				return NULL;
+				if (value <= 0 || value > INT32_MAX)
+					return BAUDRATE_INVALID;
+				return BaudRate(value);
+			}
+			// baudrate --> строка (пустая для BAUDRATE_INVALID)
+			static std::string StringFromBaudrate(BaudRate baud)
+			{
+				if (baud <= 0)
+					return std::string();
+				return std::to_string((int32_t)baud);
 			}
 			// Дефолтные настройки
 			void Defaults()
@@ -181,10 +181,12 @@ namespace cplib
 				off_char = (unsigned char)0xFF;
 				xon_lim = 128;
 				xoff_lim = 128;
+				read_min = 0;
+				low_latency = false;
 			}
 			bool IsValid() const
 			{
-				return (baud_rate != BAUDRATE_INVALID);
+				return (baud_rate > 0);
 			}
 
 			BaudRate baud_rate;
@@ -199,9 +201,146 @@ namespace cplib
 			unsigned char off_char;
 			int xon_lim;
 			int xoff_lim;
+			// VMIN (POSIX): Read ждёт хотя бы столько байт, а timeout становится
+			// паузой между байтами; 0 - Read возвращается по таймауту
+			unsigned char read_min;
+			// Просить драйвер отдавать байты сразу (Linux ASYNC_LOW_LATENCY,
+			// macOS IOSSDATALAT); где не поддерживается - игнорируется
+			bool low_latency;
 		};
 
 	private:
+#if defined(__linux__) && defined(MY_PORT_CUSTOM_BAUD)
+		// struct termios2 из <asm/termbits.h>, который конфликтует с <termios.h>
+		struct termios2
+		{
+			tcflag_t c_iflag;
+			tcflag_t c_oflag;
+			tcflag_t c_cflag;
+			tcflag_t c_lflag;
+			cc_t c_line;
+			cc_t c_cc[19];
+			speed_t c_ispeed;
+			speed_t c_ospeed;
+		};
+#endif
+#if !defined(WIN32)
+		// Стандартная скорость --> константа Bxxx; false, если такой константы нет
+		static bool SystemSpeed(int32_t baud, speed_t &speed)
+		{
+			switch (baud)
+			{
+			case 4800:
+				speed = B4800;
+				return true;
+			case 9600:
+				speed = B9600;
+				return true;
+			case 19200:
+				speed = B19200;
+				return true;
+			case 38400:
+				speed = B38400;
+				return true;
+			case 57600:
+				speed = B57600;
+				return true;
+			case 115200:
+				speed = B115200;
+				return true;
+#ifdef B230400
+			case 230400:
+				speed = B230400;
+				return true;
+#endif
+#ifdef B460800
+			case 460800:
+				speed = B460800;
+				return true;
+#endif
+#ifdef B921600
+			case 921600:
+				speed = B921600;
+				return true;
+#endif
+#ifdef B1000000
+			case 1000000:
+				speed = B1000000;
+				return true;
+#endif
+#ifdef B2000000
+			case 2000000:
+				speed = B2000000;
+				return true;
+#endif
+#ifdef B3000000
+			case 3000000:
+				speed = B3000000;
+				return true;
+#endif
+#ifdef B4000000
+			case 4000000:
+				speed = B4000000;
+				return true;
+#endif
+			default:
+				return false;
+			}
+		}
+		// Таймаут в секундах --> VTIME в децисекундах, с округлением вверх (не больше 25.5 с)
+		static cc_t TimeoutToVTime(double timeout)
+		{
+			int32_t tmms = (int32_t)(timeout * 1e3);
+			int32_t vtime = (tmms + 99) / 100;
+			if (vtime < 0)
+				vtime = 0;
+			if (vtime > 255)
+				vtime = 255;
+			return (cc_t)vtime;
+		}
+		// Нестандартная скорость поверх уже установленных параметров порта
+		int SetCustomSpeed(int32_t baud)
+		{
+#if defined(__linux__) && defined(MY_PORT_CUSTOM_BAUD)
+			struct termios2 tio;
+			if (ioctl(_phandle, TCGETS2, &tio) != 0)
+				return RE_PORT_PARAMETERS_GET_FAILED;
+			// BOTHER: скорость берётся из c_ispeed/c_ospeed, нулевая входная = выходной
+			tio.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+			tio.c_cflag |= BOTHER;
+			tio.c_ispeed = (speed_t)baud;
+			tio.c_ospeed = (speed_t)baud;
+			if (ioctl(_phandle, TCSETS2, &tio) != 0)
+				return RE_PORT_PARAMETERS_SET_FAILED;
+			return RE_OK;
+#elif defined(MY_PORT_CUSTOM_BAUD)
+			speed_t speed = (speed_t)baud;
+			if (ioctl(_phandle, IOSSIOSPEED, &speed) != 0)
+				return RE_PORT_PARAMETERS_SET_FAILED;
+			return RE_OK;
+#else
+			(void)baud;
+			return RE_PORT_INVALID_SETTINGS;
+#endif
+		}
+		// Режим низкой задержки: USB-адаптеры (FTDI и др.) иначе копят байты
+		// до 16 мс. pty и многие драйверы его не знают, это не ошибка
+		void SetLowLatency()
+		{
+#if defined(__linux__)
+			struct serial_struct ss;
+			if (ioctl(_phandle, TIOCGSERIAL, &ss) == 0)
+			{
+				ss.flags |= ASYNC_LOW_LATENCY;
+				ioctl(_phandle, TIOCSSERIAL, &ss);
+			}
+#elif defined(__APPLE__)
+			unsigned long latency_us = 1;
+			ioctl(_phandle, IOSSDATALAT, &latency_us);
+#endif
+		}
+#endif
+
 		// Открыть порт
 		int CreatePortHandle(const std::string &name)
 		{
@@ -314,9 +453,20 @@ namespace cplib
 			// *** ВАЖНО: Переводим в сырой (raw) режим ***
 			cfmakeraw(&params); // ← ЭТО КЛЮЧЕВАЯ СТРОКА!
 
-			// Теперь вручную настраиваем только то, что нужно
-			cfsetispeed(&params, inp_params.baud_rate);
-			cfsetospeed(&params, inp_params.baud_rate);
+			// Теперь вручную настраиваем только то, что нужно.
+			// Нестандартную скорость SetParameters выставит после tcsetattr
+			speed_t speed;
+			if (SystemSpeed(inp_params.baud_rate, speed))
+			{
+				cfsetispeed(&params, speed);
+				cfsetospeed(&params, speed);
+			}
+#if !defined(MY_PORT_CUSTOM_BAUD)
+			else
+			{
+				return RE_PORT_INVALID_SETTINGS;
+			}
+#endif
 
 			// Длина данных
 			params.c_cflag &= ~CSIZE;
@@ -388,8 +538,8 @@ namespace cplib
 				params.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL);
 
 			// Таймаут
-			params.c_cc[VMIN] = 0;
-			params.c_cc[VTIME] = (inp_params.timeout > 0) ? ((int32_t)(inp_params.timeout * 10) + 9) / 10 : 0;
+			params.c_cc[VMIN] = inp_params.read_min;
+			params.c_cc[VTIME] = TimeoutToVTime(inp_params.timeout);
 			// Включим получение данных и установим локальный режим
 			params.c_cflag |= (CLOCAL | CREAD);
 			// Отключим эхо
@@ -408,7 +558,7 @@ namespace cplib
 			// Сконвертируем параметры класса в системные параметры COM-порта
 			MY_PORT_SETTINGS setts;
 			int ret = ParamsToSystem(inp_params, setts);
-			if (!ret)
+			if (ret != RE_OK)
 				return ret;
 #if defined(WIN32)
 			// Системный вызов установки параметров
@@ -423,6 +573,16 @@ namespace cplib
 			// Установим системные параметры
 			if (tcsetattr(_phandle, TCSANOW, &setts))
 				return RE_PORT_PARAMETERS_SET_FAILED;
+			speed_t speed;
+			if (!SystemSpeed(inp_params.baud_rate, speed))
+			{
+				ret = SetCustomSpeed(inp_params.baud_rate);
+				if (ret != RE_OK)
+					return ret;
+			}
+			if (inp_params.low_latency)
+				SetLowLatency();
+			_read_min = inp_params.read_min;
 			ret = RE_OK;
 #endif
 			if (ret == RE_OK)
@@ -464,7 +624,10 @@ namespace cplib
 				return RE_PORT_NOT_CONNECTED;
 			int ret = ClosePortHandle();
 			_timeout = 0.0;
+			_read_min = 0;
 			_port_name.clear();
+			_rx_begin = _rx_next = _rx_scan = _rx_end = 0;
+			_rx_dropping = false;
 			return ret;
 		}
 		// Открыт ли порт
@@ -488,8 +651,8 @@ namespace cplib
 			if (!IsOpen())
 				return RE_PORT_NOT_CONNECTED;
 			int ret = RE_OK;
-			int tmms = (int32_t)(timeout * 1e3);
 #if defined(WIN32)
+			int tmms = (int32_t)(timeout * 1e3);
 			// Set COM timeouts
 			COMMTIMEOUTS tmts;
 			if (!GetCommTimeouts(_phandle, &tmts))
@@ -510,9 +673,9 @@ namespace cplib
 			MY_PORT_SETTINGS params;
 			if (tcgetattr(_phandle, &params))
 				return RE_PORT_PARAMETERS_GET_FAILED;
-			// Читаем минимально 0 байт, таймаут - в децисекундах (0.1 секунды)
-			params.c_cc[VMIN] = 0;
-			params.c_cc[VTIME] = (tmms + 99) / 100;
+			// Минимум байт - из Parameters::read_min, таймаут - в децисекундах (0.1 секунды)
+			params.c_cc[VMIN] = _read_min;
+			params.c_cc[VTIME] = TimeoutToVTime(timeout);
 			// Установим системные параметры
 			if (tcsetattr(_phandle, TCSANOW, &params))
 				return RE_PORT_PARAMETERS_SET_FAILED;
@@ -596,6 +759,68 @@ namespace cplib
 			return RE_OK;
 		}
 
+		// Читаем из порта одну полную строку (без \r\n).
+		// Байты копятся во внутреннем буфере, строки ищутся через memchr, поэтому
+		// обрывки пакетов склеиваются, а несколько пакетов за одно чтение делятся.
+		// line указывает внутрь буфера и действительна до следующего ReadLine/Read/Flush.
+		// Если за таймаут полная строка не пришла, line пуста, а принятые байты
+		// остаются в буфере. Строка длиннее MY_PORT_LINE_BUF отбрасывается.
+		int ReadLine(std::string_view &line)
+		{
+			line = std::string_view();
+			if (_rx_buf.empty())
+				_rx_buf.resize(MY_PORT_LINE_BUF);
+			// Место под предыдущую строку больше не нужно
+			_rx_begin = _rx_next;
+			if (_rx_begin == _rx_end)
+				_rx_begin = _rx_next = _rx_scan = _rx_end = 0;
+			for (;;)
+			{
+				const char *data = _rx_buf.data();
+				const char *nl = (const char *)memchr(data + _rx_scan, '\n', _rx_end - _rx_scan);
+				if (nl)
+				{
+					size_t end = (size_t)(nl - data);
+					_rx_next = _rx_scan = end + 1;
+					if (_rx_dropping)
+					{
+						_rx_dropping = false;
+						_rx_begin = _rx_next;
+						continue;
+					}
+					if (end > _rx_begin && data[end - 1] == '\r')
+						--end;
+					line = std::string_view(data + _rx_begin, end - _rx_begin);
+					return RE_OK;
+				}
+				_rx_scan = _rx_end;
+				if (_rx_end == _rx_buf.size())
+				{
+					if (_rx_begin == 0)
+					{
+						// Переполнение: отбрасываем всё до следующего \n
+						_rx_dropping = true;
+						_rx_next = _rx_scan = _rx_end = 0;
+					}
+					else
+					{
+						// Сдвигаем недочитанную строку в начало буфера
+						memmove(&_rx_buf[0], data + _rx_begin, _rx_end - _rx_begin);
+						_rx_end -= _rx_begin;
+						_rx_next = _rx_scan = _rx_end;
+						_rx_begin = 0;
+					}
+				}
+				size_t rd = 0;
+				int ret = Read(&_rx_buf[_rx_end], _rx_buf.size() - _rx_end, &rd);
+				if (ret != RE_OK)
+					return ret;
+				if (rd == 0)
+					return RE_OK; // таймаут
+				_rx_end += rd;
+			}
+		}
+
 		// Отправить все ожидающие данные устройству
 		int Flush()
 		{
@@ -608,6 +833,8 @@ namespace cplib
 #else
 			tcflush(_phandle, TCIOFLUSH);
 #endif
+			_rx_begin = _rx_next = _rx_scan = _rx_end = 0;
+			_rx_dropping = false;
 			return RE_OK;
 		}
 
@@ -627,6 +854,15 @@ namespace cplib
 		MY_PORT_HANDLE _phandle;
 		std::string _port_name;
 		double _timeout;
+		unsigned char _read_min = 0; // VMIN, сохраняется при SetTimeout
+		// Буфер ReadLine: [_rx_begin, _rx_next) - выданная строка,
+		// [_rx_next, _rx_end) - ещё не разобранные байты, до _rx_scan \n уже искали
+		std::vector<char> _rx_buf;
+		size_t _rx_begin = 0;
+		size_t _rx_next = 0;
+		size_t _rx_scan = 0;
+		size_t _rx_end = 0;
+		bool _rx_dropping = false;
 
 	private:
 		// Защита от копирования
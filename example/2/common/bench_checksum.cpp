@@ -0,0 +1,150 @@
+// Микробенчмарк проверки пакетов "значение HEX": прежний путь 4lab/5lab
+// (stringstream-разбор, std::to_string, hash_of_string через stringstream и
+// toupper, сравнение строк) против cplib::check_packet из packet_check.hpp.
+// Отдельно сравнивается только проверка контрольной суммы: SWAR + таблица и
+// чисто табличный вариант.
+// Сборка: g++ -std=c++17 -O2 bench_checksum.cpp -o bench_checksum
+// Запуск: ./bench_checksum [пакетов = 1000000]
+
+#include "packet_check.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Прежние функции из 4lab.cpp/5lab.cpp
+    std::string hash_of_string(const std::string &s)
+    {
+        std::stringstream hex_stream;
+
+        for (char c : s)
+        {
+            hex_stream << std::hex << std::setw(2) << std::setfill('0')
+                       << static_cast<int>(static_cast<unsigned char>(c));
+        }
+
+        std::string result = hex_stream.str();
+        for (char &c : result)
+        {
+            c = std::toupper(static_cast<unsigned char>(c));
+        }
+
+        return result;
+    }
+
+    bool parse_packet(std::string_view s, double &value, std::string &checksum)
+    {
+        std::stringstream ss{std::string(s)};
+
+        ss >> value >> checksum;
+
+        return !ss.fail();
+    }
+
+    bool legacy_check(std::string_view line, double &value)
+    {
+        std::string checksum;
+        return parse_packet(line, value, checksum) && hash_of_string(std::to_string(value)) == checksum;
+    }
+
+    // Только таблица, по одному байту
+    bool table_matches(std::string_view text, std::string_view hex)
+    {
+        if (hex.size() != text.size() * 2)
+            return false;
+        std::uint8_t bad = 0;
+        for (std::size_t i = 0; i < text.size(); ++i)
+        {
+            const std::uint8_t hi = cplib::detail::hex_table.value[static_cast<unsigned char>(hex[2 * i])];
+            const std::uint8_t lo = cplib::detail::hex_table.value[static_cast<unsigned char>(hex[2 * i + 1])];
+            bad |= (hi | lo) & 0xF0;
+            bad |= static_cast<std::uint8_t>(((hi << 4) | lo) ^ static_cast<unsigned char>(text[i]));
+        }
+        return bad == 0;
+    }
+
+    template <typename F>
+    double ns_per_packet(const std::vector<std::string> &packets, std::size_t &ok, F check)
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        ok = 0;
+        for (const auto &p : packets)
+            ok += check(p) ? 1 : 0;
+        const auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(packets.size());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    // Пакеты как у simulator.c; каждый 16-й испорчен в последней цифре HEX
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> temp(-30.0, 45.0);
+    std::vector<std::string> packets;
+    std::vector<std::size_t> split;
+    packets.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::string value = std::to_string(temp(rng));
+        std::string hex = hash_of_string(value);
+        if (i % 16 == 15)
+            hex.back() = hex.back() == '0' ? '1' : '0';
+        split.push_back(value.size());
+        packets.push_back(value + " " + hex);
+    }
+
+    double sink = 0.0;
+    std::size_t ok = 0;
+
+    std::printf("%zu packets, %zu bytes each on average\n", count,
+                [&] { std::size_t n = 0; for (const auto &p : packets) n += p.size(); return n / count; }());
+    std::printf("%-36s %12s %10s\n", "check", "ns/packet", "accepted");
+
+    double ns = ns_per_packet(packets, ok, [&](const std::string &p) {
+        double v;
+        const bool r = legacy_check(p, v);
+        sink += v;
+        return r;
+    });
+    std::printf("%-36s %12.1f %10zu\n", "stringstream + to_string + hash", ns, ok);
+
+    ns = ns_per_packet(packets, ok, [&](const std::string &p) {
+        double v = 0.0;
+        const bool r = cplib::check_packet(p, v);
+        sink += v;
+        return r;
+    });
+    std::printf("%-36s %12.1f %10zu\n", "cplib::check_packet", ns, ok);
+
+    std::size_t idx = 0;
+    ns = ns_per_packet(packets, ok, [&](const std::string &p) {
+        const std::size_t n = split[idx++];
+        return hash_of_string(std::to_string(std::strtod(p.c_str(), nullptr))) == std::string_view(p).substr(n + 1);
+    });
+    std::printf("%-36s %12.1f %10zu\n", "checksum only: hash_of_string", ns, ok);
+
+    idx = 0;
+    ns = ns_per_packet(packets, ok, [&](const std::string &p) {
+        const std::size_t n = split[idx++];
+        return table_matches(std::string_view(p).substr(0, n), std::string_view(p).substr(n + 1));
+    });
+    std::printf("%-36s %12.1f %10zu\n", "checksum only: table", ns, ok);
+
+    idx = 0;
+    ns = ns_per_packet(packets, ok, [&](const std::string &p) {
+        const std::size_t n = split[idx++];
+        return cplib::hex_matches(std::string_view(p).substr(0, n), std::string_view(p).substr(n + 1));
+    });
+    std::printf("%-36s %12.1f %10zu\n", "checksum only: SWAR + table", ns, ok);
+
+    return sink == 0.123 ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Проверка пакетов "значение HEX": HEX - это шестнадцатеричная запись байтов
+// текста значения. Проверка идёт прямо по принятым байтам: HEX декодируется
+// по 8 символов за раз в 64-битном регистре (SWAR), хвост - по таблице,
+// без выделения памяти и без обратного преобразования double -> строка.
+
+#include <charconv>    // std::from_chars
+#include <cstddef>
+#include <cstdint>
+#include <cstring>     // memcpy
+#include <string_view>
+#include <system_error>
+
+namespace cplib
+{
+    namespace detail
+    {
+        // Значение шестнадцатеричной цифры или 0xFF. Как и прежний
+        // hash_of_string, принимаем только заглавные A-F.
+        struct HexTable
+        {
+            std::uint8_t value[256];
+
+            constexpr HexTable() : value()
+            {
+                for (int i = 0; i < 256; ++i)
+                    value[i] = 0xFF;
+                for (int i = 0; i < 10; ++i)
+                    value['0' + i] = static_cast<std::uint8_t>(i);
+                for (int i = 0; i < 6; ++i)
+                    value['A' + i] = static_cast<std::uint8_t>(10 + i);
+            }
+        };
+
+        inline constexpr HexTable hex_table{};
+
+        inline std::uint64_t load_u64(const char *p)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline std::uint32_t load_u32(const char *p)
+        {
+            std::uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        // Декодирует 8 символов HEX в 4 байта (в порядке памяти на
+        // little-endian). Возвращает false, если среди них есть не-цифра.
+        inline bool decode_hex8(std::uint64_t v, std::uint32_t &out)
+        {
+            constexpr std::uint64_t ones = 0x0101010101010101ULL;
+            constexpr std::uint64_t high = 0x8080808080808080ULL;
+
+            // Старший бит байта = байт в [lo, hi]; верно для байтов < 0x80,
+            // остальные отсекает (v & high)
+            const std::uint64_t digit = (v + ones * (0x80 - '0')) & ~(v + ones * (0x80 - '9' - 1)) & high;
+            const std::uint64_t alpha = (v + ones * (0x80 - 'A')) & ~(v + ones * (0x80 - 'F' - 1)) & high;
+            if ((v & high) != 0 || (digit | alpha) != high)
+                return false;
+
+            // '0'..'9' -> 0..9, 'A'..'F' -> 1..6 + 9
+            const std::uint64_t nib = (v & (ones * 0x0F)) + (alpha >> 7) * 9;
+
+            // Пары полубайтов -> байты, затем сжимаем байты к младшим 32 битам
+            std::uint64_t x = ((nib << 4) | (nib >> 8)) & 0x00FF00FF00FF00FFULL;
+            x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+            x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+            out = static_cast<std::uint32_t>(x);
+            return true;
+        }
+
+        inline bool little_endian()
+        {
+            const std::uint16_t probe = 1;
+            std::uint8_t first;
+            std::memcpy(&first, &probe, 1);
+            return first == 1;
+        }
+    }
+
+    // true, если hex - шестнадцатеричная запись (заглавными) байтов text
+    inline bool hex_matches(std::string_view text, std::string_view hex)
+    {
+        if (hex.size() != text.size() * 2)
+            return false;
+
+        const char *h = hex.data();
+        const char *t = text.data();
+        std::size_t i = 0;
+
+        if (detail::little_endian())
+        {
+            for (; i + 4 <= text.size(); i += 4)
+            {
+                std::uint32_t bytes;
+                if (!detail::decode_hex8(detail::load_u64(h + 2 * i), bytes) ||
+                    bytes != detail::load_u32(t + i))
+                    return false;
+            }
+        }
+
+        std::uint8_t bad = 0;
+        for (; i < text.size(); ++i)
+        {
+            const std::uint8_t hi = detail::hex_table.value[static_cast<unsigned char>(h[2 * i])];
+            const std::uint8_t lo = detail::hex_table.value[static_cast<unsigned char>(h[2 * i + 1])];
+            bad |= (hi | lo) & 0xF0;
+            bad |= static_cast<std::uint8_t>(((hi << 4) | lo) ^ static_cast<unsigned char>(t[i]));
+        }
+        return bad == 0;
+    }
+
+    // Делит пакет "значение HEX" на две части без копирования. Пробелы и \r
+    // по краям игнорируются.
+    inline bool split_packet(std::string_view line, std::string_view &value_text, std::string_view &checksum)
+    {
+        auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+
+        std::size_t b = 0;
+        std::size_t e = line.size();
+        while (b < e && is_space(line[b]))
+            ++b;
+        while (e > b && is_space(line[e - 1]))
+            --e;
+        line = line.substr(b, e - b);
+
+        const std::size_t sp = line.find(' ');
+        if (sp == std::string_view::npos)
+            return false;
+
+        value_text = line.substr(0, sp);
+        std::size_t c = sp;
+        while (c < line.size() && is_space(line[c]))
+            ++c;
+        checksum = line.substr(c);
+        return !value_text.empty() && !checksum.empty() && checksum.find(' ') == std::string_view::npos;
+    }
+
+    // Проверяет пакет и разбирает значение. Контрольная сумма сверяется с
+    // байтами значения так, как они пришли.
+    inline bool check_packet(std::string_view line, double &value)
+    {
+        std::string_view value_text, checksum;
+        if (!split_packet(line, value_text, checksum) || !hex_matches(value_text, checksum))
+            return false;
+
+        const char *end = value_text.data() + value_text.size();
+        const auto res = std::from_chars(value_text.data(), end, value);
+        return res.ec == std::errc() && res.ptr == end;
+    }
+}
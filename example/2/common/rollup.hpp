@@ -0,0 +1,84 @@
+#pragma once
+
+// Потоковая сводка отсчётов за интервал (час, сутки): число, сумма, минимум,
+// максимум и дисперсия. Память и время на отсчёт и на сброс постоянны и не
+// зависят от частоты опроса. Дисперсия считается по Уэлфорду: разности
+// накапливаются относительно текущего среднего, поэтому нет потери точности,
+// как у суммы квадратов при значениях порядка 20 и малом разбросе.
+
+#include <cmath>   // std::sqrt
+#include <cstdint>
+
+namespace cplib
+{
+    class Rollup
+    {
+    public:
+        void Add(double value)
+        {
+            ++_count;
+            _sum += value;
+            if (_count == 1)
+            {
+                _min = value;
+                _max = value;
+            }
+            else
+            {
+                if (value < _min)
+                    _min = value;
+                if (value > _max)
+                    _max = value;
+            }
+            double delta = value - _mean;
+            _mean += delta / static_cast<double>(_count);
+            _m2 += delta * (value - _mean);
+        }
+
+        // Начать новый интервал
+        void Reset()
+        {
+            *this = Rollup();
+        }
+
+        std::uint64_t Count() const
+        {
+            return _count;
+        }
+        double Sum() const
+        {
+            return _sum;
+        }
+        // Как прежний compute_avg: sum / count, 0.0 для пустого интервала
+        double Mean() const
+        {
+            return _count ? _sum / static_cast<double>(_count) : 0.0;
+        }
+        // Для пустого интервала - 0.0
+        double Min() const
+        {
+            return _min;
+        }
+        double Max() const
+        {
+            return _max;
+        }
+        // Несмещённая (выборочная) дисперсия; 0.0, пока отсчётов меньше двух
+        double Variance() const
+        {
+            return _count > 1 ? _m2 / static_cast<double>(_count - 1) : 0.0;
+        }
+        double Stddev() const
+        {
+            return std::sqrt(Variance());
+        }
+
+    private:
+        std::uint64_t _count = 0;
+        double _sum = 0.0;
+        double _mean = 0.0; // текущее среднее для Уэлфорда
+        double _m2 = 0.0;   // сумма квадратов отклонений от среднего
+        double _min = 0.0;
+        double _max = 0.0;
+    };
+}
@@ -14,11 +14,16 @@
 #else
     #include <fcntl.h>
     #include <signal.h>
-    #include <sys/select.h>
     #include <termios.h>
     #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/epoll.h>
+    #endif
 #endif
 
+#include "frame.h"
+#include "line_reader.h"
+
 #define LOG_MEASURE "measurements.log"
 #define LOG_HOURLY "hourly.log"
 #define LOG_DAILY "daily.log"
@@ -27,6 +32,8 @@
 #define MAX_HOURLY_LOG (24 * 30)
 #define MAX_DAILY_LOG 365
 
+#define MAX_PORTS 64
+
 #ifndef _WIN32
 static volatile sig_atomic_t g_running = 1;
 #else
@@ -48,6 +55,49 @@ struct RollingStats {
     size_t count;
 };
 
+/* Порт со своим буфером разбора строк и своей статистикой */
+struct Port {
+    const char *device;
+    char sensor[32];
+#ifdef _WIN32
+    HANDLE fd;
+#else
+    int fd;
+#endif
+    struct LineReader reader;
+    struct FrameDecoder decoder;
+    struct SeqTracker seq;
+    struct MeasurementBuffer buffer;
+    /* Часы устройства из FRAME_BATCH: настенное время = device_ms + offset */
+    bool clock_synced;
+    int64_t clock_offset_ms;
+    uint32_t last_device_ms;
+    uint32_t clock_restarts;
+    struct RollingStats hour_stats;
+    struct RollingStats day_stats;
+};
+
+static struct Port g_ports[MAX_PORTS];
+static size_t g_port_count = 0;
+/* Дописывать ID датчика в логи (несколько портов или явный ID) */
+static bool g_tagged = false;
+
+/* Формат на линии: текстовые строки "%.6f HEX" или двоичные кадры frame.h */
+enum Proto { PROTO_TEXT, PROTO_BINARY };
+static enum Proto g_proto = PROTO_TEXT;
+
+/* Сводка приёма для --stats, печатается в stderr при завершении (её читает loopback) */
+struct IngestStats {
+    uint64_t received; /* отсчётов с верной контрольной суммой или CRC */
+    uint64_t accepted; /* из них прошли проверки диапазона и скачка */
+    uint32_t *latency_us; /* от времени устройства до разбора, только FRAME_BATCH */
+    size_t latency_count;
+    size_t latency_cap;
+};
+
+static bool g_stats = false;
+static struct IngestStats g_ingest;
+
 static time_t now_ts(void) {
     return time(NULL);
 }
@@ -85,6 +135,10 @@ static size_t count_lines(const char *file_path) {
     return count;
 }
 
+/* Число строк в логах по типу; файл пересчитывается только при первой записи */
+static size_t g_log_lines[3];
+static bool g_log_counted[3];
+
 static void reset_if_oversize(const char *file_path, int type) {
     size_t limit = 0;
     switch (type) {
@@ -101,55 +155,121 @@ static void reset_if_oversize(const char *file_path, int type) {
         return;
     }
 
-    const size_t lines = count_lines(file_path);
-    if (lines >= limit)
+    if (!g_log_counted[type]) {
+        g_log_lines[type] = count_lines(file_path);
+        g_log_counted[type] = true;
+    }
+    if (g_log_lines[type] >= limit) {
         remove(file_path);
+        g_log_lines[type] = 0;
+    }
 }
 
-static void append_line(const char *file_path, const char *msg, int type) {
+/* Дописывает lines строк из text (каждая с \n) одним открытием файла */
+static void append_lines(const char *file_path, const char *text, size_t lines, int type) {
     reset_if_oversize(file_path, type);
 
     FILE *f = fopen(file_path, "a");
     if (!f)
         return;
 
-    fprintf(f, "%s\n", msg);
+    fputs(text, f);
     fclose(f);
+    if (type >= 0 && type < 3)
+        g_log_lines[type] += lines;
+}
+
+static void append_line(const char *file_path, const char *msg, int type) {
+    char line[160];
+    snprintf(line, sizeof(line), "%s\n", msg);
+    append_lines(file_path, line, 1, type);
 }
 
-static void double_to_string(double value, char *out, size_t out_size) {
-    /* std::to_string uses 6 digits after the decimal point */
-    snprintf(out, out_size, "%.6f", value);
+/* Значение шестнадцатеричной цифры (только заглавные, как у simulator.c) или 0xFF */
+static uint8_t g_hex_value[256];
+
+static void init_hex_table(void) {
+    memset(g_hex_value, 0xFF, sizeof(g_hex_value));
+    for (int i = 0; i < 10; ++i)
+        g_hex_value['0' + i] = (uint8_t)i;
+    for (int i = 0; i < 6; ++i)
+        g_hex_value['A' + i] = (uint8_t)(10 + i);
 }
 
-static void hash_of_string(const char *src, char *dst, size_t dst_size) {
-    size_t len = strlen(src);
-    size_t needed = len * 2 + 1;
-    if (dst_size < needed) {
-        if (dst_size > 0)
-            dst[0] = '\0';
-        return;
+/* Декодирует 8 символов HEX (загружены little-endian) в 4 байта за раз:
+ * проверка диапазонов и перевод в полубайты идут сразу во всех байтах
+ * 64-битного слова. Возвращает false, если есть не-цифра. */
+static bool decode_hex8(uint64_t v, uint32_t *out) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t high = 0x8080808080808080ULL;
+
+    /* Старший бит байта = байт в диапазоне; верно для байтов < 0x80 */
+    uint64_t digit = (v + ones * (0x80 - '0')) & ~(v + ones * (0x80 - '9' - 1)) & high;
+    uint64_t alpha = (v + ones * (0x80 - 'A')) & ~(v + ones * (0x80 - 'F' - 1)) & high;
+    if ((v & high) != 0 || (digit | alpha) != high)
+        return false;
+
+    uint64_t nib = (v & (ones * 0x0F)) + (alpha >> 7) * 9;
+    uint64_t x = ((nib << 4) | (nib >> 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    *out = (uint32_t)x;
+    return true;
+}
+
+/* true, если hex - шестнадцатеричная запись байтов text. Сверяет принятые
+ * байты напрямую, без snprintf и обратного перевода double в строку. */
+static bool hex_matches(const char *text, size_t len, const char *hex, size_t hex_len) {
+    if (hex_len != len * 2)
+        return false;
+
+    size_t i = 0;
+    const uint16_t probe = 1;
+    if (*(const uint8_t *)&probe == 1) {
+        for (; i + 4 <= len; i += 4) {
+            uint64_t v;
+            uint32_t bytes, expected;
+            memcpy(&v, hex + 2 * i, sizeof(v));
+            memcpy(&expected, text + i, sizeof(expected));
+            if (!decode_hex8(v, &bytes) || bytes != expected)
+                return false;
+        }
     }
 
-    for (size_t i = 0; i < len; ++i) {
-        unsigned char c = (unsigned char)src[i];
-        snprintf(dst + i * 2, 3, "%02X", c);
+    uint8_t bad = 0;
+    for (; i < len; ++i) {
+        uint8_t hi = g_hex_value[(unsigned char)hex[2 * i]];
+        uint8_t lo = g_hex_value[(unsigned char)hex[2 * i + 1]];
+        bad |= (uint8_t)((hi | lo) & 0xF0);
+        bad |= (uint8_t)(((hi << 4) | lo) ^ (unsigned char)text[i]);
     }
+    return bad == 0;
 }
 
-static bool parse_packet(const char *line, double *value, char *checksum, size_t checksum_size) {
-    if (!line || !value || !checksum || checksum_size == 0)
+/* Разбирает "значение HEX" и сверяет HEX с байтами значения, как они пришли */
+static bool parse_packet(const char *line, double *value) {
+    if (!line || !value)
         return false;
 
-    double v = 0.0;
-    char chk_local[128];
+    const char *sp = strchr(line, ' ');
+    if (!sp || sp == line)
+        return false;
+    size_t value_len = (size_t)(sp - line);
 
-    if (sscanf(line, "%lf %127s", &v, chk_local) != 2)
+    const char *hex = sp + 1;
+    size_t hex_len = strlen(hex);
+    while (hex_len > 0 && (hex[hex_len - 1] == ' ' || hex[hex_len - 1] == '\r'))
+        --hex_len;
+
+    if (!hex_matches(line, value_len, hex, hex_len))
+        return false;
+
+    char *end = NULL;
+    double v = strtod(line, &end);
+    if (end != sp)
         return false;
 
     *value = v;
-    strncpy(checksum, chk_local, checksum_size - 1);
-    checksum[checksum_size - 1] = '\0';
     return true;
 }
 
@@ -220,7 +340,7 @@ static int configure_serial(int fd) {
 }
 
 static int open_serial_port(const char *device) {
-    int fd = open(device, O_RDWR | O_NOCTTY | O_SYNC);
+    int fd = open(device, O_RDWR | O_NOCTTY | O_SYNC | O_NONBLOCK);
     if (fd < 0)
         return -1;
 
@@ -233,93 +353,336 @@ static int open_serial_port(const char *device) {
 }
 #endif
 
-#ifdef _WIN32
-static ssize_t read_line_timeout(HANDLE hSerial, char *buf, size_t buf_size, int timeout_sec) {
-    (void)timeout_sec; /* timeout set in handle */
-    if (buf_size == 0)
-        return -1;
+static void format_record(char *out, size_t out_size, time_t ts, double value, const struct Port *port) {
+    if (g_tagged)
+        snprintf(out, out_size, "%ld %.6f %s", (long)ts, value, port->sensor);
+    else
+        snprintf(out, out_size, "%ld %.6f", (long)ts, value);
+}
 
+static void flush_measurements(struct Port *port) {
+    struct MeasurementBuffer *buffer = &port->buffer;
+    char block[sizeof(buffer->items) / sizeof(buffer->items[0]) * 128];
     size_t pos = 0;
+    for (size_t i = 0; i < buffer->size; ++i) {
+        format_record(block + pos, sizeof(block) - pos - 1, buffer->items[i].ts, buffer->items[i].value, port);
+        pos += strlen(block + pos);
+        block[pos++] = '\n';
+    }
+    block[pos] = '\0';
+    if (buffer->size > 0)
+        append_lines(LOG_MEASURE, block, buffer->size, 0);
+    buffer->size = 0;
+}
+
+static void record_average(const char *file_path, int type, const char *what, const struct Port *port,
+                           struct RollingStats *stats) {
+    if (stats->count > 0) {
+        char avg_line[128];
+        double avg = compute_avg(stats);
+        format_record(avg_line, sizeof(avg_line), now_ts(), avg, port);
+        append_line(file_path, avg_line, type);
+        if (g_tagged)
+            printf("[%s] %s: %.6f (count: %zu)\n", port->sensor, what, avg, stats->count);
+        else
+            printf("%s: %.6f (count: %zu)\n", what, avg, stats->count);
+    }
 
-    while (pos + 1 < buf_size) {
-        char ch;
-        DWORD bytesRead = 0;
+    stats->sum = 0.0;
+    stats->count = 0;
+}
 
-        if (!ReadFile(hSerial, &ch, 1, &bytesRead, NULL)) {
-            return -1;
-        }
+/* Проверяет значение и кладёт его в буфер порта. Возвращает false, если
+ * значение отброшено. */
+static bool store_value(struct Port *port, time_t ts, double value) {
+    struct MeasurementBuffer *buffer = &port->buffer;
+    bool value_ok = (value >= -60.0 && value <= 60.0);
 
-        if (bytesRead == 1) {
-            if (ch == '\n' || ch == '\r')
-                break;
-            buf[pos++] = ch;
-        } else {
-            break; /* timeout or no data */
+    if (buffer->size > 0) {
+        double diff = fabs(value - buffer->items[buffer->size - 1].value);
+        value_ok = value_ok && (diff < 1.0);
+    }
+
+    if (!value_ok)
+        return false;
+
+    buffer->items[buffer->size].ts = ts;
+    buffer->items[buffer->size].value = value;
+    buffer->size++;
+
+    if (buffer->size >= 10) {
+        /* ИСПРАВЛЕНО: Добавляем ВСЕ значения из буфера в статистику */
+        for (size_t i = 0; i < buffer->size; ++i) {
+            port->hour_stats.sum += buffer->items[i].value;
+            port->day_stats.sum += buffer->items[i].value;
         }
+        port->hour_stats.count += buffer->size;
+        port->day_stats.count += buffer->size;
+
+        flush_measurements(port);
     }
+    return true;
+}
+
+static void handle_value(struct Port *port, double value) {
+    ++g_ingest.received;
+    if (!store_value(port, now_ts(), value))
+        return;
+    ++g_ingest.accepted;
 
-    buf[pos] = '\0';
-    return (ssize_t)pos;
+    if (g_tagged)
+        printf("[%s] New value -> %.6f\n", port->sensor, value);
+    else
+        printf("New value -> %.6f\n", value);
 }
+
+/* Пачка отсчётов одного кадра: те же проверки, одна строка на пачку */
+static void handle_batch(struct Port *port, const struct Measurement *items, size_t count) {
+    size_t accepted = 0;
+    for (size_t i = 0; i < count; ++i)
+        accepted += store_value(port, items[i].ts, items[i].value);
+    g_ingest.received += count;
+    g_ingest.accepted += accepted;
+
+    if (g_tagged)
+        printf("[%s] New batch -> %zu/%zu values, last %.6f\n", port->sensor, accepted, count,
+               items[count - 1].value);
+    else
+        printf("New batch -> %zu/%zu values, last %.6f\n", accepted, count, items[count - 1].value);
+}
+
+static int64_t monotonic_us(void) {
+#ifdef _WIN32
+    return (int64_t)GetTickCount64() * 1000;
 #else
-static ssize_t read_line_timeout(int fd, char *buf, size_t buf_size, int timeout_sec) {
-    if (buf_size == 0)
-        return -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
 
-    size_t pos = 0;
+/* Задержка отсчёта с монотонным временем устройства (в мс, как у simulator.c
+ * на той же машине). Точность ограничена миллисекундой часов устройства. */
+static void record_latency(uint32_t device_ms) {
+    int64_t now = monotonic_us();
+    uint32_t now_ms = (uint32_t)(now / 1000);
+    uint32_t lat = (uint32_t)(now_ms - device_ms) * 1000u + (uint32_t)(now % 1000);
+
+    if (g_ingest.latency_count == g_ingest.latency_cap) {
+        size_t cap = g_ingest.latency_cap ? g_ingest.latency_cap * 2 : 4096;
+        uint32_t *p = realloc(g_ingest.latency_us, cap * sizeof(*p));
+        if (!p)
+            return;
+        g_ingest.latency_us = p;
+        g_ingest.latency_cap = cap;
+    }
+    g_ingest.latency_us[g_ingest.latency_count++] = lat;
+}
 
-    while (pos + 1 < buf_size) {
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(fd, &readfds);
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
 
-        struct timeval tv;
-        tv.tv_sec = timeout_sec;
-        tv.tv_usec = 0;
+static uint32_t percentile(const uint32_t *sorted, size_t n, double p) {
+    if (n == 0)
+        return 0;
+    size_t idx = (size_t)(p * (double)(n - 1) + 0.5);
+    return sorted[idx];
+}
 
-        int rv = select(fd + 1, &readfds, NULL, NULL, &tv);
-        if (rv == 0) {
-            break; /* timeout */
-        } else if (rv < 0) {
-            if (errno == EINTR)
-                continue;
-            return -1;
+static void print_ingest_stats(void) {
+    uint64_t lost = 0;
+    uint64_t bad = 0;
+    for (size_t i = 0; i < g_port_count; ++i) {
+        lost += g_ports[i].seq.lost;
+        bad += g_ports[i].decoder.errors;
+    }
+
+    size_t n = g_ingest.latency_count;
+    if (n > 0)
+        qsort(g_ingest.latency_us, n, sizeof(uint32_t), compare_u32);
+
+    fprintf(stderr,
+            "stats received=%llu accepted=%llu lost_frames=%llu bad_frames=%llu latency_samples=%zu "
+            "p50_us=%u p90_us=%u p99_us=%u max_us=%u\n",
+            (unsigned long long)g_ingest.received, (unsigned long long)g_ingest.accepted,
+            (unsigned long long)lost, (unsigned long long)bad, n, percentile(g_ingest.latency_us, n, 0.50),
+            percentile(g_ingest.latency_us, n, 0.90), percentile(g_ingest.latency_us, n, 0.99),
+            n > 0 ? g_ingest.latency_us[n - 1] : 0);
+    free(g_ingest.latency_us);
+}
+
+static int64_t wall_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Привязывает монотонные часы устройства к настенным по последнему отсчёту
+ * пачки. Привязка обновляется после перезапуска устройства или скачка назад. */
+static void sync_device_clock(struct Port *port, uint32_t first_ms, uint32_t last_ms) {
+    bool restarted = port->seq.restarts != port->clock_restarts;
+    bool backwards = (int32_t)(first_ms - port->last_device_ms) < 0;
+    if (!port->clock_synced || restarted || backwards) {
+        port->clock_offset_ms = wall_ms() - (int64_t)last_ms;
+        port->clock_restarts = port->seq.restarts;
+        port->clock_synced = true;
+    }
+    port->last_device_ms = last_ms;
+}
+
+static void handle_line(struct Port *port, const char *line) {
+    double value = 0.0;
+    if (parse_packet(line, &value))
+        handle_value(port, value);
+}
+
+static void handle_frame(struct Port *port, const struct Frame *frame) {
+    if (!seq_tracker_check(&port->seq, frame->seq))
+        return;
+    if (frame->type == FRAME_SAMPLE && frame->len == 4) {
+        handle_value(port, frame_sample_value(frame));
+    } else if (frame->type == FRAME_BATCH) {
+        struct FrameSample samples[FRAME_BATCH_MAX];
+        size_t count = frame_decode_batch(frame, samples, FRAME_BATCH_MAX);
+        if (count == 0)
+            return;
+
+        sync_device_clock(port, samples[0].device_ms, samples[count - 1].device_ms);
+        if (g_stats) {
+            for (size_t i = 0; i < count; ++i)
+                record_latency(samples[i].device_ms);
         }
+        struct Measurement items[FRAME_BATCH_MAX];
+        for (size_t i = 0; i < count; ++i) {
+            items[i].ts = (time_t)((port->clock_offset_ms + (int64_t)samples[i].device_ms) / 1000);
+            items[i].value = samples[i].value;
+        }
+        handle_batch(port, items, count);
+    }
+}
 
-        char ch;
-        ssize_t n = read(fd, &ch, 1);
-        if (n == 1) {
-            if (ch == '\n' || ch == '\r')
-                break;
-            buf[pos++] = ch;
-        } else if (n == 0) {
-            break; /* EOF or no data */
-        } else {
-            if (errno == EINTR)
-                continue;
-            return -1;
+/* Разбирает всё, что накопилось в буфере порта */
+static void process_input(struct Port *port) {
+    struct LineReader *r = &port->reader;
+
+    if (g_proto == PROTO_BINARY) {
+        struct Frame frame;
+        for (size_t i = r->start; i < r->end; ++i) {
+            if (frame_decoder_push(&port->decoder, (uint8_t)r->buf[i], &frame))
+                handle_frame(port, &frame);
         }
+        r->start = 0;
+        r->end = 0;
+        return;
     }
 
-    buf[pos] = '\0';
-    return (ssize_t)pos;
+    char line[256];
+    while (line_reader_next(r, line, sizeof(line)) > 0)
+        handle_line(port, line);
+}
+
+static void print_link_stats(const struct Port *port) {
+    if (g_proto != PROTO_BINARY)
+        return;
+    printf("Port %s: %u frames, %u lost, %u duplicates, %u restarts, %u bad frames\n", port->device,
+           port->decoder.frames, port->seq.lost, port->seq.duplicates, port->seq.restarts, port->decoder.errors);
+}
+
+static void check_rollover(int *last_hour, int *last_mday) {
+    struct tm cur_tm = local_tm(now_ts());
+
+    if (cur_tm.tm_hour != *last_hour) {
+        for (size_t i = 0; i < g_port_count; ++i)
+            record_average(LOG_HOURLY, 1, "Hourly average recorded", &g_ports[i], &g_ports[i].hour_stats);
+        *last_hour = cur_tm.tm_hour;
+    }
+
+    if (cur_tm.tm_mday != *last_mday) {
+        for (size_t i = 0; i < g_port_count; ++i)
+            record_average(LOG_DAILY, 2, "Daily average recorded", &g_ports[i], &g_ports[i].day_stats);
+        *last_mday = cur_tm.tm_mday;
+    }
+}
+
+#ifndef _WIN32
+/* Забирает всё, что пришло в неблокирующий порт, и разбирает строки.
+ * Возвращает -1, если порт закрыт или сломан. */
+static int service_port(struct Port *port) {
+    for (;;) {
+        size_t space = sizeof(port->reader.buf) - port->reader.end;
+        ssize_t n = line_reader_drain(&port->reader);
+        if (n < 0)
+            return -1;
+
+        process_input(port);
+
+        /* Короткое чтение: порт опустел, остальное придёт со следующим событием */
+        if ((size_t)n < space)
+            return 0;
+    }
+}
+
+static void close_port(struct Port *port) {
+    fprintf(stderr, "Port %s closed\n", port->device);
+    close(port->fd);
+    port->fd = -1;
 }
 #endif
 
-static void flush_measurements(struct MeasurementBuffer *buffer) {
-    for (size_t i = 0; i < buffer->size; ++i) {
-        char line[128];
-        snprintf(line, sizeof(line), "%ld %.6f", (long)buffer->items[i].ts, buffer->items[i].value);
-        append_line(LOG_MEASURE, line, 0);
+static bool parse_port_arg(char *arg, struct Port *port, size_t index) {
+    /* "порт=ID"; без ID датчик нумеруется по порядку */
+    char *eq = strrchr(arg, '=');
+    if (eq) {
+        *eq = '\0';
+        if (eq[1] == '\0' || strlen(eq + 1) >= sizeof(port->sensor))
+            return false;
+        strcpy(port->sensor, eq + 1);
+        g_tagged = true;
+    } else {
+        snprintf(port->sensor, sizeof(port->sensor), "%zu", index + 1);
     }
-    buffer->size = 0;
+    port->device = arg;
+    return arg[0] != '\0';
 }
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s [port]\n", argv[0]);
+    int first_port = 1;
+    while (first_port < argc && strncmp(argv[first_port], "--", 2) == 0) {
+        const char *opt = argv[first_port];
+        if (strcmp(opt, "--proto") == 0 && first_port + 1 < argc) {
+            const char *val = argv[first_port + 1];
+            if (strcmp(val, "binary") == 0) {
+                g_proto = PROTO_BINARY;
+            } else if (strcmp(val, "text") != 0) {
+                fprintf(stderr, "Unknown protocol: %s (expected text or binary)\n", val);
+                return -1;
+            }
+            first_port += 2;
+        } else if (strcmp(opt, "--stats") == 0) {
+            g_stats = true;
+            ++first_port;
+        } else {
+            break;
+        }
+    }
+
+    if (argc - first_port < 1 || strncmp(argv[first_port], "--", 2) == 0) {
+        fprintf(stderr, "Usage: %s [--proto text|binary] [--stats] port[=sensor] [port[=sensor] ...]\n", argv[0]);
+        return -1;
+    }
+    if ((size_t)(argc - first_port) > MAX_PORTS) {
+        fprintf(stderr, "Too many ports (max %d)\n", MAX_PORTS);
         return -1;
     }
+#ifdef _WIN32
+    if (argc - first_port > 1) {
+        fprintf(stderr, "Only one port is supported on Windows\n");
+        return -1;
+    }
+#endif
 
 #ifndef _WIN32
     /* Устанавливаем обработчики сигналов */
@@ -327,137 +690,136 @@ int main(int argc, char **argv) {
     signal(SIGTERM, signal_handler);
 #endif
 
-#ifdef _WIN32
-    HANDLE serial_fd = open_serial_port(argv[1]);
-    if (serial_fd == INVALID_HANDLE_VALUE) {
-        fprintf(stderr, "Failed to open port %s\n", argv[1]);
-        return -2;
+    init_hex_table();
+
+    g_port_count = (size_t)(argc - first_port);
+    for (size_t i = 0; i < g_port_count; ++i) {
+        struct Port *port = &g_ports[i];
+        if (!parse_port_arg(argv[first_port + i], port, i)) {
+            fprintf(stderr, "Bad port argument: %s\n", argv[first_port + i]);
+            return -1;
+        }
     }
+    /* Один порт без ID пишет логи в прежнем формате */
+    g_tagged = g_tagged || g_port_count > 1;
+
+    for (size_t i = 0; i < g_port_count; ++i) {
+        struct Port *port = &g_ports[i];
+#ifdef _WIN32
+        port->fd = open_serial_port(port->device);
+        if (port->fd == INVALID_HANDLE_VALUE) {
+            fprintf(stderr, "Failed to open port %s\n", port->device);
+            return -2;
+        }
 #else
-    int serial_fd = open_serial_port(argv[1]);
-    if (serial_fd < 0) {
-        fprintf(stderr, "Failed to open port %s: %s\n", argv[1], strerror(errno));
-        return -2;
-    }
+        port->fd = open_serial_port(port->device);
+        if (port->fd < 0) {
+            fprintf(stderr, "Failed to open port %s: %s\n", port->device, strerror(errno));
+            return -2;
+        }
 #endif
-
-    struct RollingStats hour_stats = {0};
-    struct RollingStats day_stats = {0};
-    struct MeasurementBuffer buffer = {0};
+        line_reader_init(&port->reader, port->fd);
+        frame_decoder_init(&port->decoder);
+    }
 
     struct tm last_tm = local_tm(now_ts());
     int last_hour = last_tm.tm_hour;
     int last_mday = last_tm.tm_mday;
 
-    char line[256];
-
-    printf("Temperature logger started. Press Ctrl+C to stop.\n");
+    printf("Temperature logger started on %zu port(s). Press Ctrl+C to stop.\n", g_port_count);
 
+#ifdef _WIN32
     while (g_running) {
-        ssize_t len = read_line_timeout(serial_fd, line, sizeof(line), 1);
-        if (len > 0) {
-            double value = 0.0;
-            char checksum[128];
-
-            if (parse_packet(line, &value, checksum, sizeof(checksum))) {
-                bool value_ok = (value >= -60.0 && value <= 60.0);
-
-                if (buffer.size > 0) {
-                    double diff = fabs(value - buffer.items[buffer.size - 1].value);
-                    value_ok = value_ok && (diff < 1.0);
-                }
-
-                if (value_ok) {
-                    char value_str[64];
-                    double_to_string(value, value_str, sizeof(value_str));
-
-                    char calc[128];
-                    hash_of_string(value_str, calc, sizeof(calc));
-
-                    if (strcmp(calc, checksum) == 0) {
-                        printf("New value -> %.6f\n", value);
-                        time_t ts = now_ts();
-
-                        buffer.items[buffer.size].ts = ts;
-                        buffer.items[buffer.size].value = value;
-                        buffer.size++;
-
-                        if (buffer.size >= 10) {
-                            /* ИСПРАВЛЕНО: Добавляем ВСЕ значения из буфера в статистику */
-                            for (size_t i = 0; i < buffer.size; ++i) {
-                                hour_stats.sum += buffer.items[i].value;
-                                day_stats.sum += buffer.items[i].value;
-                            }
-                            hour_stats.count += buffer.size;
-                            day_stats.count += buffer.size;
-                            
-                            flush_measurements(&buffer);
-                        }
-                    }
-                }
-            }
-
-            struct tm cur_tm = local_tm(now_ts());
-
-            if (cur_tm.tm_hour != last_hour) {
-                if (hour_stats.count > 0) {
-                    char hourly_line[128];
-                    double avg = compute_avg(&hour_stats);
-                    snprintf(hourly_line, sizeof(hourly_line), "%ld %.6f", (long)now_ts(), avg);
-                    append_line(LOG_HOURLY, hourly_line, 1);
-                    printf("Hourly average recorded: %.6f (count: %zu)\n", avg, hour_stats.count);
-                }
+        if (line_reader_fill(&g_ports[0].reader, 1) < 0)
+            break;
+        process_input(&g_ports[0]);
+        check_rollover(&last_hour, &last_mday);
+    }
+#elif defined(__linux__)
+    /* Один epoll на все порты; порт приходит в событии через data.ptr */
+    int ep = epoll_create1(0);
+    if (ep < 0) {
+        perror("epoll_create1");
+        return -2;
+    }
+    for (size_t i = 0; i < g_port_count; ++i) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.ptr = &g_ports[i];
+        if (epoll_ctl(ep, EPOLL_CTL_ADD, g_ports[i].fd, &ev) != 0) {
+            fprintf(stderr, "Failed to watch port %s: %s\n", g_ports[i].device, strerror(errno));
+            return -2;
+        }
+    }
 
-                hour_stats.sum = 0.0;
-                hour_stats.count = 0;
-                last_hour = cur_tm.tm_hour;
+    size_t active = g_port_count;
+    while (g_running && active > 0) {
+        struct epoll_event events[MAX_PORTS];
+        int n = epoll_wait(ep, events, MAX_PORTS, 1000);
+        if (n < 0 && errno != EINTR)
+            break;
+
+        for (int i = 0; i < n; ++i) {
+            struct Port *port = events[i].data.ptr;
+            if (service_port(port) != 0) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, port->fd, NULL);
+                close_port(port);
+                --active;
             }
+        }
+        check_rollover(&last_hour, &last_mday);
+    }
+    close(ep);
+#else
+    /* Без epoll: тот же цикл на poll() */
+    struct pollfd fds[MAX_PORTS];
+    size_t active = g_port_count;
+    while (g_running && active > 0) {
+        for (size_t i = 0; i < g_port_count; ++i) {
+            fds[i].fd = g_ports[i].fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        int n = poll(fds, (nfds_t)g_port_count, 1000);
+        if (n < 0 && errno != EINTR)
+            break;
 
-            if (cur_tm.tm_mday != last_mday) {
-                if (day_stats.count > 0) {
-                    char daily_line[128];
-                    double avg = compute_avg(&day_stats);
-                    snprintf(daily_line, sizeof(daily_line), "%ld %.6f", (long)now_ts(), avg);
-                    append_line(LOG_DAILY, daily_line, 2);
-                    printf("Daily average recorded: %.6f (count: %zu)\n", avg, day_stats.count);
-                }
-
-                day_stats.sum = 0.0;
-                day_stats.count = 0;
-                last_mday = cur_tm.tm_mday;
+        for (size_t i = 0; n > 0 && i < g_port_count; ++i) {
+            if (fds[i].revents == 0)
+                continue;
+            if (service_port(&g_ports[i]) != 0) {
+                close_port(&g_ports[i]);
+                --active;
             }
         }
+        check_rollover(&last_hour, &last_mday);
     }
+#endif
 
     /* Финальная запись данных перед завершением */
     printf("\nShutting down...\n");
-    
-    if (buffer.size > 0) {
-        printf("Flushing %zu remaining measurements\n", buffer.size);
-        flush_measurements(&buffer);
-    }
-    
-    if (hour_stats.count > 0) {
-        char hourly_line[128];
-        double avg = compute_avg(&hour_stats);
-        snprintf(hourly_line, sizeof(hourly_line), "%ld %.6f", (long)now_ts(), avg);
-        append_line(LOG_HOURLY, hourly_line, 1);
-        printf("Final hourly average: %.6f (count: %zu)\n", avg, hour_stats.count);
-    }
-    
-    if (day_stats.count > 0) {
-        char daily_line[128];
-        double avg = compute_avg(&day_stats);
-        snprintf(daily_line, sizeof(daily_line), "%ld %.6f", (long)now_ts(), avg);
-        append_line(LOG_DAILY, daily_line, 2);
-        printf("Final daily average: %.6f (count: %zu)\n", avg, day_stats.count);
-    }
+
+    for (size_t i = 0; i < g_port_count; ++i) {
+        struct Port *port = &g_ports[i];
+        if (port->buffer.size > 0) {
+            printf("Flushing %zu remaining measurements from %s\n", port->buffer.size, port->device);
+            flush_measurements(port);
+        }
+        record_average(LOG_HOURLY, 1, "Final hourly average", port, &port->hour_stats);
+        record_average(LOG_DAILY, 2, "Final daily average", port, &port->day_stats);
+        print_link_stats(port);
 
 #ifdef _WIN32
-    CloseHandle(serial_fd);
+        CloseHandle(port->fd);
 #else
-    close(serial_fd);
+        if (port->fd >= 0)
+            close(port->fd);
 #endif
+    }
+    if (g_stats)
+        print_ingest_stats();
     printf("Temperature logger stopped.\n");
     return 0;
 }
@@ -0,0 +1,241 @@
+/* Бенчмарк чтения строк из pty: прежний select()+read() по одному байту
+ * против буферизованного poll()-читателя из line_reader.h.
+ * Использование: bench_reader [packets=100000] [baud=0]
+ * baud=0 — писатель шлёт пакеты без пауз, иначе темп ограничен скоростью
+ * порта (10 бит на байт). Время CPU считается только для потока-читателя. */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "line_reader.h"
+
+struct Writer {
+    int fd;
+    long packets;
+    long baud;
+    atomic_int done;
+};
+
+struct Result {
+    long lines;
+    long bytes;
+    size_t syscalls;
+    double cpu_sec;
+    double wall_sec;
+};
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double thread_cpu_sec(void) {
+    struct rusage ru;
+#ifdef RUSAGE_THREAD
+    getrusage(RUSAGE_THREAD, &ru);
+#else
+    getrusage(RUSAGE_SELF, &ru);
+#endif
+    return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+           (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+/* Пакет в формате simulator.c: "%.6f HEX\n" */
+static size_t make_packet(long i, char *out, size_t out_size) {
+    char value_str[32];
+    snprintf(value_str, sizeof(value_str), "%.6f", 20.0 + (double)(i % 1000) / 100.0);
+    size_t len = strlen(value_str);
+    size_t pos = (size_t)snprintf(out, out_size, "%s ", value_str);
+    for (size_t k = 0; k < len && pos + 3 < out_size; ++k)
+        pos += (size_t)snprintf(out + pos, 3, "%02X", (unsigned char)value_str[k]);
+    out[pos++] = '\n';
+    return pos;
+}
+
+static void *writer_main(void *arg) {
+    struct Writer *w = arg;
+    double start = now_sec();
+    long sent_bytes = 0;
+    char packet[128];
+
+    for (long i = 0; i < w->packets; ++i) {
+        size_t len = make_packet(i, packet, sizeof(packet));
+        size_t off = 0;
+        while (off < len) {
+            ssize_t n = write(w->fd, packet + off, len - off);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                atomic_store(&w->done, 1);
+                return NULL;
+            }
+            off += (size_t)n;
+        }
+        sent_bytes += (long)len;
+
+        if (w->baud > 0) {
+            double due = start + (double)sent_bytes * 10.0 / (double)w->baud;
+            double wait = due - now_sec();
+            if (wait > 0) {
+                struct timespec ts;
+                ts.tv_sec = (time_t)wait;
+                ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+    atomic_store(&w->done, 1);
+    return NULL;
+}
+
+/* Прежний read_line_timeout из 4.c */
+static ssize_t legacy_read_line(int fd, char *buf, size_t buf_size, int timeout_sec, size_t *syscalls) {
+    if (buf_size == 0)
+        return -1;
+
+    size_t pos = 0;
+
+    while (pos + 1 < buf_size) {
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(fd, &readfds);
+
+        struct timeval tv;
+        tv.tv_sec = timeout_sec;
+        tv.tv_usec = 0;
+
+        ++*syscalls;
+        int rv = select(fd + 1, &readfds, NULL, NULL, &tv);
+        if (rv == 0) {
+            break; /* timeout */
+        } else if (rv < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        char ch;
+        ++*syscalls;
+        ssize_t n = read(fd, &ch, 1);
+        if (n == 1) {
+            if (ch == '\n' || ch == '\r')
+                break;
+            buf[pos++] = ch;
+        } else if (n == 0) {
+            break; /* EOF or no data */
+        } else {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+    }
+
+    buf[pos] = '\0';
+    return (ssize_t)pos;
+}
+
+static int open_pty(int *master, int *slave) {
+    *master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0)
+        return -1;
+
+    const char *name = ptsname(*master);
+    if (!name)
+        return -1;
+    *slave = open(name, O_RDWR | O_NOCTTY);
+    if (*slave < 0)
+        return -1;
+
+    /* Как configure_serial в 4.c: raw, VMIN=0, VTIME=10 */
+    struct termios tty;
+    if (tcgetattr(*slave, &tty) != 0)
+        return -1;
+    cfmakeraw(&tty);
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 10;
+    return tcsetattr(*slave, TCSANOW, &tty);
+}
+
+static int run(bool buffered, long packets, long baud, struct Result *res) {
+    int master = -1;
+    int slave = -1;
+    if (open_pty(&master, &slave) != 0) {
+        perror("pty");
+        return -1;
+    }
+
+    struct Writer w;
+    w.fd = master;
+    w.packets = packets;
+    w.baud = baud;
+    atomic_init(&w.done, 0);
+    struct LineReader reader;
+    line_reader_init(&reader, slave);
+    char line[256];
+    size_t legacy_syscalls = 0;
+
+    memset(res, 0, sizeof(*res));
+    double cpu0 = thread_cpu_sec();
+    double wall0 = now_sec();
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, writer_main, &w);
+
+    while (res->lines < packets) {
+        ssize_t len = buffered ? read_line_timeout(&reader, line, sizeof(line), 1)
+                               : legacy_read_line(slave, line, sizeof(line), 1, &legacy_syscalls);
+        if (len < 0)
+            break;
+        if (len == 0) {
+            /* Таймаут после конца записи: остальное потеряно */
+            if (atomic_load(&w.done))
+                break;
+            continue;
+        }
+        ++res->lines;
+        res->bytes += len + 1;
+    }
+
+    res->wall_sec = now_sec() - wall0;
+    res->cpu_sec = thread_cpu_sec() - cpu0;
+    res->syscalls = buffered ? reader.reads * 2 : legacy_syscalls;
+
+    pthread_join(writer, NULL);
+    close(slave);
+    close(master);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long packets = argc > 1 ? atol(argv[1]) : 100000;
+    long baud = argc > 2 ? atol(argv[2]) : 0;
+
+    if (baud > 0)
+        printf("%ld packets paced at %ld baud\n", packets, baud);
+    else
+        printf("%ld packets unpaced\n", packets);
+    printf("%-16s %10s %12s %14s %14s %10s\n", "reader", "lines", "packets/s", "cpu us/packet", "syscalls/pkt",
+           "lost");
+
+    for (int buffered = 0; buffered <= 1; ++buffered) {
+        struct Result r;
+        if (run(buffered, packets, baud, &r) != 0)
+            return 1;
+        double per = r.lines > 0 ? (double)r.lines : 1.0;
+        printf("%-16s %10ld %12.0f %14.2f %14.2f %10ld\n", buffered ? "poll+buffer" : "select+read(1)", r.lines,
+               (double)r.lines / r.wall_sec, r.cpu_sec * 1e6 / per, (double)r.syscalls / per, packets - r.lines);
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+#ifndef LAB4_FRAME_H
+#define LAB4_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Двоичный кадр датчика в стиле HDLC.
+ *
+ *   0x7E | len | type | seq(2) | body(len) | crc16(2) | 0x7E
+ *
+ * Многобайтовые поля little-endian. CRC-16/CCITT-FALSE считается по
+ * len..body. Между флагами байты 0x7E и 0x7D передаются как 0x7D, b ^ 0x20,
+ * поэтому флаг внутри кадра не встречается: после мусора или обрыва приёмник
+ * ловит следующий 0x7E и синхронизируется заново. */
+
+#define FRAME_FLAG 0x7E
+#define FRAME_ESC 0x7D
+#define FRAME_ESC_XOR 0x20
+
+#define FRAME_HEADER_SIZE 4
+#define FRAME_CRC_SIZE 2
+#define FRAME_MAX_BODY 240
+#define FRAME_MAX_RAW (FRAME_HEADER_SIZE + FRAME_MAX_BODY + FRAME_CRC_SIZE)
+/* Худший случай: каждый байт экранирован, плюс два флага */
+#define FRAME_MAX_WIRE (2 * FRAME_MAX_RAW + 2)
+
+/* Одно значение: int32, градусы * FRAME_VALUE_SCALE */
+#define FRAME_SAMPLE 0x01
+#define FRAME_VALUE_SCALE 1000000.0
+
+struct Frame {
+    uint8_t type;
+    uint16_t seq;
+    uint8_t len;
+    const uint8_t *body; /* указывает в буфер декодера до следующего байта */
+};
+
+static inline void frame_put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void frame_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t frame_get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t frame_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), таблица по полубайтам */
+static inline uint16_t frame_crc16(const uint8_t *data, size_t len) {
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+static inline int32_t frame_value_to_fixed(double value) {
+    double scaled = value * FRAME_VALUE_SCALE;
+    return (int32_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+static inline double frame_fixed_to_value(int32_t fixed) {
+    return (double)fixed / FRAME_VALUE_SCALE;
+}
+
+/* Кодирует кадр в out (не меньше FRAME_MAX_WIRE байт). Возвращает длину на
+ * линии или 0, если тело слишком длинное. */
+static inline size_t frame_encode(uint8_t type, uint16_t seq, const uint8_t *body, size_t len, uint8_t *out) {
+    if (len > FRAME_MAX_BODY)
+        return 0;
+
+    uint8_t raw[FRAME_MAX_RAW];
+    raw[0] = (uint8_t)len;
+    raw[1] = type;
+    frame_put_u16(raw + 2, seq);
+    if (len > 0)
+        memcpy(raw + FRAME_HEADER_SIZE, body, len);
+    size_t raw_len = FRAME_HEADER_SIZE + len;
+    frame_put_u16(raw + raw_len, frame_crc16(raw, raw_len));
+    raw_len += FRAME_CRC_SIZE;
+
+    size_t pos = 0;
+    out[pos++] = FRAME_FLAG;
+    for (size_t i = 0; i < raw_len; ++i) {
+        uint8_t b = raw[i];
+        if (b == FRAME_FLAG || b == FRAME_ESC) {
+            out[pos++] = FRAME_ESC;
+            b ^= FRAME_ESC_XOR;
+        }
+        out[pos++] = b;
+    }
+    out[pos++] = FRAME_FLAG;
+    return pos;
+}
+
+static inline size_t frame_encode_sample(uint16_t seq, double value, uint8_t *out) {
+    uint8_t body[4];
+    frame_put_u32(body, (uint32_t)frame_value_to_fixed(value));
+    return frame_encode(FRAME_SAMPLE, seq, body, sizeof(body), out);
+}
+
+static inline double frame_sample_value(const struct Frame *frame) {
+    return frame_fixed_to_value((int32_t)frame_get_u32(frame->body));
+}
+
+/* Пачка отсчётов: u32 время устройства первого отсчёта (мс, монотонное),
+ * u8 число отсчётов, затем на каждый u16 смещение от первого (мс) и int32
+ * значение, как в FRAME_SAMPLE */
+#define FRAME_BATCH 0x02
+#define FRAME_BATCH_HEADER 5
+#define FRAME_BATCH_ITEM 6
+#define FRAME_BATCH_MAX ((FRAME_MAX_BODY - FRAME_BATCH_HEADER) / FRAME_BATCH_ITEM)
+
+struct FrameSample {
+    uint32_t device_ms;
+    double value;
+};
+
+/* Возвращает длину кадра на линии или 0, если отсчётов нет, их больше
+ * FRAME_BATCH_MAX или они не укладываются в 65 с от первого. */
+static inline size_t frame_encode_batch(uint16_t seq, const struct FrameSample *samples, size_t count, uint8_t *out) {
+    if (count == 0 || count > FRAME_BATCH_MAX)
+        return 0;
+
+    uint8_t body[FRAME_MAX_BODY];
+    uint32_t base = samples[0].device_ms;
+    frame_put_u32(body, base);
+    body[4] = (uint8_t)count;
+
+    uint8_t *p = body + FRAME_BATCH_HEADER;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t offset = samples[i].device_ms - base;
+        if (offset > 0xFFFF)
+            return 0;
+        frame_put_u16(p, (uint16_t)offset);
+        frame_put_u32(p + 2, (uint32_t)frame_value_to_fixed(samples[i].value));
+        p += FRAME_BATCH_ITEM;
+    }
+    return frame_encode(FRAME_BATCH, seq, body, (size_t)(p - body), out);
+}
+
+/* Разбирает тело FRAME_BATCH в out за один проход. Возвращает число
+ * отсчётов или 0, если тело повреждено либо не помещается в out. */
+static inline size_t frame_decode_batch(const struct Frame *frame, struct FrameSample *out, size_t max) {
+    if (frame->type != FRAME_BATCH || frame->len < FRAME_BATCH_HEADER)
+        return 0;
+
+    size_t count = frame->body[4];
+    if (count == 0 || count > max || frame->len != FRAME_BATCH_HEADER + count * FRAME_BATCH_ITEM)
+        return 0;
+
+    uint32_t base = frame_get_u32(frame->body);
+    const uint8_t *p = frame->body + FRAME_BATCH_HEADER;
+    for (size_t i = 0; i < count; ++i) {
+        out[i].device_ms = base + frame_get_u16(p);
+        out[i].value = frame_fixed_to_value((int32_t)frame_get_u32(p + 2));
+        p += FRAME_BATCH_ITEM;
+    }
+    return count;
+}
+
+/* Побайтовый приёмник кадров */
+struct FrameDecoder {
+    uint8_t raw[FRAME_MAX_RAW];
+    size_t len;
+    bool escaped;
+    bool overflow;
+    uint32_t frames; /* принятых кадров */
+    uint32_t errors; /* отброшенных: CRC, длина, переполнение */
+};
+
+static inline void frame_decoder_init(struct FrameDecoder *d) {
+    memset(d, 0, sizeof(*d));
+}
+
+/* Проверяет накопленный кадр; пустые промежутки между флагами не считаются */
+static inline bool frame_decoder_finish(struct FrameDecoder *d, struct Frame *out) {
+    size_t len = d->len;
+    bool overflow = d->overflow;
+    bool escaped = d->escaped;
+    d->len = 0;
+    d->overflow = false;
+    d->escaped = false;
+
+    if (len == 0 && !overflow)
+        return false;
+    if (overflow || escaped || len < FRAME_HEADER_SIZE + FRAME_CRC_SIZE ||
+        (size_t)d->raw[0] + FRAME_HEADER_SIZE + FRAME_CRC_SIZE != len) {
+        ++d->errors;
+        return false;
+    }
+
+    size_t crc_pos = len - FRAME_CRC_SIZE;
+    if (frame_crc16(d->raw, crc_pos) != frame_get_u16(d->raw + crc_pos)) {
+        ++d->errors;
+        return false;
+    }
+
+    out->len = d->raw[0];
+    out->type = d->raw[1];
+    out->seq = frame_get_u16(d->raw + 2);
+    out->body = d->raw + FRAME_HEADER_SIZE;
+    ++d->frames;
+    return true;
+}
+
+/* Принимает очередной байт. Возвращает true, когда байт закрыл корректный кадр. */
+static inline bool frame_decoder_push(struct FrameDecoder *d, uint8_t byte, struct Frame *out) {
+    if (byte == FRAME_FLAG)
+        return frame_decoder_finish(d, out);
+
+    if (byte == FRAME_ESC) {
+        d->escaped = true;
+        return false;
+    }
+    if (d->escaped) {
+        byte ^= FRAME_ESC_XOR;
+        d->escaped = false;
+    }
+
+    if (d->len < sizeof(d->raw))
+        d->raw[d->len++] = byte;
+    else
+        d->overflow = true;
+    return false;
+}
+
+/* Учёт номеров кадров: пропуски и повторы */
+#define FRAME_SEQ_DUP_WINDOW 64
+
+struct SeqTracker {
+    bool started;
+    uint16_t next;
+    uint32_t lost;
+    uint32_t duplicates;
+    uint32_t restarts;
+};
+
+/* Возвращает false для повтора уже принятого кадра. Скачок назад дальше окна
+ * повторов считается перезапуском устройства. */
+static inline bool seq_tracker_check(struct SeqTracker *t, uint16_t seq) {
+    if (!t->started) {
+        t->started = true;
+        t->next = (uint16_t)(seq + 1);
+        return true;
+    }
+
+    uint16_t ahead = (uint16_t)(seq - t->next);
+    if (ahead < 0x8000) {
+        t->lost += ahead;
+    } else if ((uint16_t)(t->next - seq) <= FRAME_SEQ_DUP_WINDOW) {
+        ++t->duplicates;
+        return false;
+    } else {
+        ++t->restarts;
+    }
+    t->next = (uint16_t)(seq + 1);
+    return true;
+}
+
+#endif
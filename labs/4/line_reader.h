@@ -0,0 +1,155 @@
+#ifndef LAB4_LINE_READER_H
+#define LAB4_LINE_READER_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <poll.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+#define LINE_READER_SIZE 4096
+
+/* Буферизованное чтение строк из порта: за одно пробуждение забираются все
+ * доступные байты, строки выделяются прямо в буфере, а недочитанный хвост
+ * переносится в начало буфера до следующего чтения. */
+struct LineReader {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+    char buf[LINE_READER_SIZE];
+    size_t start;  /* первый неразобранный байт */
+    size_t end;    /* конец принятых данных */
+    bool overflow; /* отбрасываем хвост слишком длинной строки */
+    size_t reads;  /* системных вызовов чтения (для статистики) */
+};
+
+#ifdef _WIN32
+static inline void line_reader_init(struct LineReader *r, HANDLE handle) {
+    memset(r, 0, sizeof(*r));
+    r->handle = handle;
+}
+#else
+static inline void line_reader_init(struct LineReader *r, int fd) {
+    memset(r, 0, sizeof(*r));
+    r->fd = fd;
+}
+#endif
+
+/* Дочитывает в буфер всё, что уже пришло. Возвращает число байт,
+ * 0 при таймауте (или прерывании сигналом) и -1 при ошибке. */
+static inline ssize_t line_reader_fill(struct LineReader *r, int timeout_sec) {
+    size_t space = sizeof(r->buf) - r->end;
+#ifdef _WIN32
+    /* Таймауты заданы в SetCommTimeouts */
+    (void)timeout_sec;
+    DWORD bytes_read = 0;
+    ++r->reads;
+    if (!ReadFile(r->handle, r->buf + r->end, (DWORD)space, &bytes_read, NULL))
+        return -1;
+    r->end += bytes_read;
+    return (ssize_t)bytes_read;
+#else
+    struct pollfd pfd;
+    pfd.fd = r->fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int rv = poll(&pfd, 1, timeout_sec * 1000);
+    if (rv == 0)
+        return 0;
+    if (rv < 0)
+        return (errno == EINTR) ? 0 : -1;
+
+    ++r->reads;
+    ssize_t n = read(r->fd, r->buf + r->end, space);
+    if (n < 0)
+        return (errno == EINTR || errno == EAGAIN) ? 0 : -1;
+    r->end += (size_t)n;
+    return n;
+#endif
+}
+
+/* Выделяет из буфера очередную непустую строку (без \r\n) в buf. Возвращает
+ * её длину или 0, если полной строки в буфере нет; тогда недочитанный хвост
+ * переносится в начало буфера. Строка длиннее buf обрезается. */
+static inline size_t line_reader_next(struct LineReader *r, char *buf, size_t buf_size) {
+    for (;;) {
+        const char *line = r->buf + r->start;
+        const char *nl = memchr(line, '\n', r->end - r->start);
+        if (!nl)
+            break;
+
+        size_t len = (size_t)(nl - line);
+        r->start += len + 1;
+        if (r->overflow) {
+            r->overflow = false;
+            continue;
+        }
+        if (len > 0 && line[len - 1] == '\r')
+            --len;
+        if (len == 0)
+            continue;
+        if (len >= buf_size)
+            len = buf_size - 1;
+        memcpy(buf, line, len);
+        buf[len] = '\0';
+        return len;
+    }
+
+    /* Переносим недочитанную строку в начало буфера */
+    if (r->start > 0) {
+        memmove(r->buf, r->buf + r->start, r->end - r->start);
+        r->end -= r->start;
+        r->start = 0;
+    }
+    if (r->end == sizeof(r->buf)) {
+        r->overflow = true;
+        r->end = 0;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+/* Одно чтение без ожидания для неблокирующего fd. Возвращает число байт,
+ * 0 если данных пока нет, -1 при ошибке или закрытии порта. */
+static inline ssize_t line_reader_drain(struct LineReader *r) {
+    ++r->reads;
+    ssize_t n = read(r->fd, r->buf + r->end, sizeof(r->buf) - r->end);
+    if (n < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    if (n == 0)
+        return -1;
+    r->end += (size_t)n;
+    return n;
+}
+#endif
+
+/* Читает одну непустую строку (без \r\n) в buf. Возвращает её длину, 0 если
+ * за timeout_sec полная строка не пришла (принятая часть остаётся в буфере),
+ * -1 при ошибке. Строка длиннее buf обрезается. */
+static inline ssize_t read_line_timeout(struct LineReader *r, char *buf, size_t buf_size, int timeout_sec) {
+    if (buf_size == 0)
+        return -1;
+    buf[0] = '\0';
+
+    for (;;) {
+        size_t len = line_reader_next(r, buf, buf_size);
+        if (len > 0)
+            return (ssize_t)len;
+
+        ssize_t n = line_reader_fill(r, timeout_sec);
+        if (n <= 0)
+            return n;
+    }
+}
+
+#endif
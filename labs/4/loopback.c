@@ -0,0 +1,403 @@
+/* Стенд без железа: simulator и lab4 соединяются через пары псевдотерминалов.
+ *
+ *   simulator -> pty A (slave) | master A -> линия -> master B | pty B (slave) -> lab4
+ *
+ * Между мастерами работает «линия»: она забирает байты у симулятора не
+ * быстрее заданного baud (10 бит на байт), поэтому симулятор упирается в
+ * скорость порта, как с настоящим UART. Если lab4 не успевает и буфер pty B
+ * полон, байты пропадают, как при переполнении приёмника.
+ *
+ * Использование: loopback [--proto text|binary] [--rate HZ] [--batch N]
+ *                         [--count N] [--ports K] [--baud B] [--bin DIR]
+ * Пишет сводку: пакетов в секунду, потери, задержку от времени устройства до
+ * разбора в lab4 (только --batch, точность 1 мс часов устройства) и CPU на
+ * пакет для lab4 и симулятора. Логи lab4 пишутся во временный каталог. */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+    #include <util.h>
+#else
+    #include <pty.h>
+#endif
+
+#define MAX_LINKS 64
+
+struct Options {
+    const char *proto;
+    const char *rate;
+    const char *batch;
+    long count;
+    int ports;
+    long baud;
+    char bin_dir[PATH_MAX];
+};
+
+/* Одна линия: pty A со стороны симулятора, pty B со стороны lab4 */
+struct Link {
+    int master_a;
+    int slave_a;
+    int master_b;
+    int slave_b;
+    char name_a[128];
+    char name_b[128];
+    pid_t simulator;
+    bool sim_done;
+    bool drained;
+    struct rusage sim_usage;
+    uint64_t line_bytes;
+    uint64_t overrun_bytes;
+};
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double cpu_sec(const struct rusage *ru) {
+    return (double)(ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) +
+           (double)(ru->ru_utime.tv_usec + ru->ru_stime.tv_usec) / 1e6;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--proto text|binary] [--rate HZ] [--batch N] [--count N] [--ports K] [--baud B] [--bin DIR]\n"
+            "  --rate HZ   samples per second per port (default 100)\n"
+            "  --batch N   samples per frame, binary only (default: one frame per sample)\n"
+            "  --count N   samples per port (default 2000)\n"
+            "  --ports K   simulator/logger links (default 1)\n"
+            "  --baud B    line speed, 0 = unlimited (default 115200)\n"
+            "  --bin DIR   where lab4 and simulator are (default: next to loopback)\n",
+            prog);
+}
+
+static int parse_options(int argc, char **argv, struct Options *o) {
+    o->proto = "binary";
+    o->rate = "100";
+    o->batch = NULL;
+    o->count = 2000;
+    o->ports = 1;
+    o->baud = 115200;
+
+    const char *slash = strrchr(argv[0], '/');
+    if (slash)
+        snprintf(o->bin_dir, sizeof(o->bin_dir), "%.*s", (int)(slash - argv[0]), argv[0]);
+    else
+        snprintf(o->bin_dir, sizeof(o->bin_dir), ".");
+
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc)
+            return -1;
+        const char *opt = argv[i];
+        const char *val = argv[i + 1];
+        if (strcmp(opt, "--proto") == 0)
+            o->proto = val;
+        else if (strcmp(opt, "--rate") == 0)
+            o->rate = val;
+        else if (strcmp(opt, "--batch") == 0)
+            o->batch = val;
+        else if (strcmp(opt, "--count") == 0)
+            o->count = atol(val);
+        else if (strcmp(opt, "--ports") == 0)
+            o->ports = atoi(val);
+        else if (strcmp(opt, "--baud") == 0)
+            o->baud = atol(val);
+        else if (strcmp(opt, "--bin") == 0)
+            snprintf(o->bin_dir, sizeof(o->bin_dir), "%s", val);
+        else
+            return -1;
+    }
+
+    if (o->count <= 0 || o->ports < 1 || o->ports > MAX_LINKS || o->baud < 0)
+        return -1;
+    if (o->batch && strcmp(o->proto, "binary") != 0)
+        return -1;
+
+    /* Дочерние процессы запускаются из временного каталога, поэтому
+     * относительный путь (./loopback, --bin build) делаем абсолютным. */
+    char resolved[PATH_MAX];
+    if (realpath(o->bin_dir, resolved))
+        snprintf(o->bin_dir, sizeof(o->bin_dir), "%s", resolved);
+    return 0;
+}
+
+/* Pty в raw до запуска программ: иначе первые байты успеет исказить
+ * канонический режим */
+static int open_raw_pty(int *master, int *slave, char *name) {
+    struct termios tty;
+    memset(&tty, 0, sizeof(tty));
+    cfmakeraw(&tty);
+    if (openpty(master, slave, name, &tty, NULL) != 0)
+        return -1;
+    fcntl(*master, F_SETFL, fcntl(*master, F_GETFL) | O_NONBLOCK);
+    /* Дочерние процессы не должны держать чужие концы: иначе master A не
+     * увидит закрытия порта симулятором */
+    fcntl(*master, F_SETFD, FD_CLOEXEC);
+    fcntl(*slave, F_SETFD, FD_CLOEXEC);
+    return 0;
+}
+
+static pid_t spawn(char *const argv[], const char *dir, int out_fd, int err_fd) {
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    if (dir && chdir(dir) != 0)
+        _exit(127);
+    dup2(out_fd, STDOUT_FILENO);
+    dup2(err_fd, STDERR_FILENO);
+    execv(argv[0], argv);
+    perror(argv[0]);
+    _exit(127);
+}
+
+/* Переносит байты A -> B в пределах бюджета линии. Возвращает перенесённое. */
+static size_t relay(struct Link *link, size_t budget) {
+    char buf[4096];
+    size_t moved = 0;
+
+    while (moved < budget) {
+        size_t want = budget - moved < sizeof(buf) ? budget - moved : sizeof(buf);
+        ssize_t n = read(link->master_a, buf, want);
+        if (n <= 0) {
+            /* EIO: симулятор закрыл порт и всё вычитано */
+            if (n == 0 || (errno != EAGAIN && errno != EINTR))
+                link->drained = link->sim_done;
+            break;
+        }
+        moved += (size_t)n;
+        link->line_bytes += (uint64_t)n;
+
+        ssize_t w = write(link->master_b, buf, (size_t)n);
+        if (w < 0)
+            w = 0;
+        link->overrun_bytes += (uint64_t)(n - w);
+    }
+    return moved;
+}
+
+static bool parse_stats(const char *text, const char *key, unsigned long long *out) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), " %s=", key);
+    const char *p = strstr(text, pattern);
+    if (!p)
+        return false;
+    *out = strtoull(p + strlen(pattern), NULL, 10);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    struct Options opt;
+    if (parse_options(argc, argv, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char lab4_path[PATH_MAX + 16];
+    char sim_path[PATH_MAX + 16];
+    snprintf(lab4_path, sizeof(lab4_path), "%s/lab4", opt.bin_dir);
+    snprintf(sim_path, sizeof(sim_path), "%s/simulator", opt.bin_dir);
+    if (access(lab4_path, X_OK) != 0 || access(sim_path, X_OK) != 0) {
+        fprintf(stderr, "lab4 and simulator not found in %s (use --bin)\n", opt.bin_dir);
+        return 1;
+    }
+
+    char work_dir[] = "/tmp/lab4_loopback_XXXXXX";
+    if (!mkdtemp(work_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    static struct Link links[MAX_LINKS];
+    for (int i = 0; i < opt.ports; ++i) {
+        if (open_raw_pty(&links[i].master_a, &links[i].slave_a, links[i].name_a) != 0 ||
+            open_raw_pty(&links[i].master_b, &links[i].slave_b, links[i].name_b) != 0) {
+            perror("openpty");
+            return 1;
+        }
+    }
+
+    int devnull = open("/dev/null", O_WRONLY);
+    int err_pipe[2];
+    if (devnull < 0 || pipe(err_pipe) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    fcntl(err_pipe[0], F_SETFD, FD_CLOEXEC);
+
+    /* lab4 на всех портах B */
+    char *lab4_argv[MAX_LINKS + 5];
+    int k = 0;
+    lab4_argv[k++] = lab4_path;
+    lab4_argv[k++] = "--proto";
+    lab4_argv[k++] = (char *)opt.proto;
+    lab4_argv[k++] = "--stats";
+    for (int i = 0; i < opt.ports; ++i)
+        lab4_argv[k++] = links[i].name_b;
+    lab4_argv[k] = NULL;
+
+    pid_t logger = spawn(lab4_argv, work_dir, devnull, err_pipe[1]);
+    close(err_pipe[1]);
+
+    /* Даём lab4 открыть порты */
+    struct timespec settle = {0, 300 * 1000000L};
+    nanosleep(&settle, NULL);
+
+    char count_str[32];
+    snprintf(count_str, sizeof(count_str), "%ld", opt.count);
+    double t_start = now_sec();
+    for (int i = 0; i < opt.ports; ++i) {
+        char *sim_argv[12];
+        int j = 0;
+        sim_argv[j++] = sim_path;
+        sim_argv[j++] = "--proto";
+        sim_argv[j++] = (char *)opt.proto;
+        sim_argv[j++] = "--rate";
+        sim_argv[j++] = (char *)opt.rate;
+        if (opt.batch) {
+            sim_argv[j++] = "--batch";
+            sim_argv[j++] = (char *)opt.batch;
+        }
+        sim_argv[j++] = "--count";
+        sim_argv[j++] = count_str;
+        sim_argv[j++] = links[i].name_a;
+        sim_argv[j] = NULL;
+        links[i].simulator = spawn(sim_argv, NULL, devnull, devnull);
+    }
+
+    /* Линия: бюджет байт копится со скоростью baud / 10, не больше чем за 10 мс
+     * простоя, чтобы после паузы не было всплеска быстрее линии */
+    double bytes_per_sec = opt.baud > 0 ? (double)opt.baud / 10.0 : 0.0;
+    double line_clock = now_sec();
+    double t_last_byte = t_start;
+    int remaining = opt.ports;
+    while (remaining > 0) {
+        struct pollfd fds[MAX_LINKS];
+        for (int i = 0; i < opt.ports; ++i) {
+            fds[i].fd = links[i].drained ? -1 : links[i].master_a;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        poll(fds, (nfds_t)opt.ports, 10);
+
+        size_t budget = SIZE_MAX;
+        if (bytes_per_sec > 0) {
+            double now = now_sec();
+            if (now - line_clock > 0.01)
+                line_clock = now - 0.01;
+            budget = (size_t)((now - line_clock) * bytes_per_sec);
+            if (budget == 0) {
+                struct timespec ts = {0, 200000};
+                nanosleep(&ts, NULL);
+                continue;
+            }
+            line_clock += (double)budget / bytes_per_sec;
+        }
+
+        for (int i = 0; i < opt.ports; ++i) {
+            struct Link *link = &links[i];
+            if (link->drained)
+                continue;
+
+            if (!link->sim_done) {
+                int status;
+                if (wait4(link->simulator, &status, WNOHANG, &link->sim_usage) == link->simulator) {
+                    link->sim_done = true;
+                    /* Теперь master A вернёт EIO, когда данные кончатся */
+                    close(link->slave_a);
+                }
+            }
+
+            if (relay(link, budget) > 0)
+                t_last_byte = now_sec();
+            if (link->drained) {
+                close(link->master_a);
+                --remaining;
+            }
+        }
+    }
+
+    /* Ждём, пока lab4 разберёт хвост, и останавливаем его */
+    nanosleep(&settle, NULL);
+    kill(logger, SIGINT);
+    struct rusage logger_usage;
+    int status;
+    wait4(logger, &status, 0, &logger_usage);
+
+    char report[4096];
+    size_t len = 0;
+    ssize_t n;
+    while (len + 1 < sizeof(report) && (n = read(err_pipe[0], report + len, sizeof(report) - 1 - len)) > 0)
+        len += (size_t)n;
+    report[len] = '\0';
+
+    const char *stats = strstr(report, "stats ");
+    unsigned long long received = 0, accepted = 0, lost_frames = 0, bad_frames = 0, lat_n = 0;
+    unsigned long long p50 = 0, p90 = 0, p99 = 0, pmax = 0;
+    if (!stats || !parse_stats(stats, "received", &received)) {
+        fprintf(stderr, "lab4 did not report stats:\n%s", report);
+        return 1;
+    }
+    parse_stats(stats, "accepted", &accepted);
+    parse_stats(stats, "lost_frames", &lost_frames);
+    parse_stats(stats, "bad_frames", &bad_frames);
+    parse_stats(stats, "latency_samples", &lat_n);
+    parse_stats(stats, "p50_us", &p50);
+    parse_stats(stats, "p90_us", &p90);
+    parse_stats(stats, "p99_us", &p99);
+    parse_stats(stats, "max_us", &pmax);
+
+    uint64_t line_bytes = 0, overrun = 0;
+    double sim_cpu = 0.0;
+    for (int i = 0; i < opt.ports; ++i) {
+        line_bytes += links[i].line_bytes;
+        overrun += links[i].overrun_bytes;
+        sim_cpu += cpu_sec(&links[i].sim_usage);
+    }
+
+    unsigned long long sent = (unsigned long long)opt.count * (unsigned long long)opt.ports;
+    double elapsed = t_last_byte - t_start;
+    double per = received > 0 ? (double)received : 1.0;
+
+    printf("proto %s, %s Hz x %d port(s), %ld samples each, batch %s, baud %ld\n", opt.proto, opt.rate, opt.ports,
+           opt.count, opt.batch ? opt.batch : "-", opt.baud);
+    printf("sent                 %llu samples, %.1f line bytes/sample\n", sent, (double)line_bytes / (double)sent);
+    printf("received             %llu (%llu passed range checks)\n", received, accepted);
+    printf("dropped              %.2f%% (%llu lost frames, %llu bad frames, %llu overrun bytes)\n",
+           sent > 0 ? 100.0 * (double)(sent - (received < sent ? received : sent)) / (double)sent : 0.0, lost_frames,
+           bad_frames, (unsigned long long)overrun);
+    printf("throughput           %.0f samples/s over %.2f s\n", (double)received / elapsed, elapsed);
+    if (lat_n > 0)
+        printf("latency us           p50 %llu  p90 %llu  p99 %llu  max %llu\n", p50, p90, p99, pmax);
+    else
+        printf("latency us           n/a (needs --batch: only FRAME_BATCH carries device time)\n");
+    printf("lab4 cpu             %.2f us/sample\n", cpu_sec(&logger_usage) * 1e6 / per);
+    printf("simulator cpu        %.2f us/sample\n", sim_cpu * 1e6 / (double)sent);
+    printf("logs                 %s\n", work_dir);
+
+    for (int i = 0; i < opt.ports; ++i) {
+        close(links[i].master_b);
+        close(links[i].slave_b);
+    }
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <fcntl.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +8,8 @@
 #include <unistd.h>
 #include <math.h>
 
+#include "frame.h"
+
 static void double_to_string(double value, char *out, size_t out_size) {
     snprintf(out, out_size, "%.6f", value);
 }
@@ -55,13 +58,83 @@ static int configure_serial(int fd) {
     return 0;
 }
 
+static uint32_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000);
+}
+
+/* Ждёт следующего такта, не накапливая ошибку от времени отправки */
+static void wait_next_tick(struct timespec *next, long period_ns) {
+    next->tv_nsec += period_ns;
+    while (next->tv_nsec >= 1000000000L) {
+        next->tv_nsec -= 1000000000L;
+        next->tv_sec++;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    struct timespec delay;
+    delay.tv_sec = next->tv_sec - now.tv_sec;
+    delay.tv_nsec = next->tv_nsec - now.tv_nsec;
+    if (delay.tv_nsec < 0) {
+        delay.tv_nsec += 1000000000L;
+        delay.tv_sec--;
+    }
+    if (delay.tv_sec >= 0)
+        nanosleep(&delay, NULL);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--proto text|binary] [--rate HZ] [--batch N] [--count N] [port]\n", prog);
+    fprintf(stderr, "  --batch N  samples per FRAME_BATCH frame (binary only, up to %d)\n", FRAME_BATCH_MAX);
+    fprintf(stderr, "  --count N  stop after N samples\n");
+}
+
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s [port]\n", argv[0]);
+    int binary = 0;
+    double rate = 1.0;
+    long batch = 0; /* 0: по кадру FRAME_SAMPLE на отсчёт */
+    long count = 0;  /* 0: без ограничения */
+
+    int port_arg = 1;
+    for (; port_arg + 1 < argc && strncmp(argv[port_arg], "--", 2) == 0; port_arg += 2) {
+        const char *opt = argv[port_arg];
+        const char *val = argv[port_arg + 1];
+        if (strcmp(opt, "--proto") == 0) {
+            if (strcmp(val, "binary") == 0) {
+                binary = 1;
+            } else if (strcmp(val, "text") != 0) {
+                fprintf(stderr, "Unknown protocol: %s (expected text or binary)\n", val);
+                return -1;
+            }
+        } else if (strcmp(opt, "--rate") == 0) {
+            rate = atof(val);
+        } else if (strcmp(opt, "--batch") == 0) {
+            batch = atol(val);
+        } else if (strcmp(opt, "--count") == 0) {
+            count = atol(val);
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (port_arg != argc - 1 || rate <= 0.0 || batch < 0 || batch > FRAME_BATCH_MAX || count < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+    if (batch > 0 && !binary) {
+        fprintf(stderr, "--batch requires --proto binary\n");
+        return -1;
+    }
+    /* Смещения в FRAME_BATCH 16-битные: пачка должна укладываться в 65 с */
+    if (batch > 1 && (double)(batch - 1) * 1000.0 / rate > 0xFFFF) {
+        fprintf(stderr, "--batch %ld at %.3g Hz spans more than 65 s per frame\n", batch, rate);
         return -1;
     }
 
-    int fd = open(argv[1], O_RDWR | O_NOCTTY | O_SYNC);
+    int fd = open(argv[port_arg], O_RDWR | O_NOCTTY | O_SYNC);
     if (fd < 0) {
         perror("Failed to open port");
         return -2;
@@ -76,38 +149,74 @@ int main(int argc, char **argv) {
     srand(time(NULL));
     double base_temp = 20.0;
 
-    printf("Temperature simulator started on %s\n", argv[1]);
+    uint16_t seq = 0;
+    struct FrameSample pending[FRAME_BATCH_MAX];
+    size_t pending_count = 0;
+
+    long period_ns = (long)(1e9 / rate);
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    printf("Temperature simulator started on %s (%s, %.1f Hz, %ld per frame)\n", argv[port_arg],
+           binary ? "binary" : "text", rate, batch);
     printf("Press Ctrl+C to stop\n");
 
-    for (;;) {
+    for (long n = 0; count == 0 || n < count; ++n) {
         // Генерируем температуру с небольшими колебаниями
         double variation = ((double)rand() / RAND_MAX) * 2.0 - 1.0; // от -1 до 1
         double temperature = base_temp + variation;
 
-        char value_str[64];
-        double_to_string(temperature, value_str, sizeof(value_str));
-
-        char checksum[128];
-        hash_of_string(value_str, checksum, sizeof(checksum));
+        // Медленно меняем базовую температуру (около 0.1 градуса в секунду)
+        base_temp += (((double)rand() / RAND_MAX) * 0.2 - 0.1) / rate;
+        if (base_temp < 15.0) base_temp = 15.0;
+        if (base_temp > 25.0) base_temp = 25.0;
 
-        char packet[256];
-        snprintf(packet, sizeof(packet), "%s %s\n", value_str, checksum);
+        char packet[FRAME_MAX_WIRE];
+        size_t packet_len;
+        size_t frame_samples = 1;
+        if (batch > 0) {
+            /* Отсчёт со временем устройства; кадр уходит, когда пачка набрана */
+            pending[pending_count].device_ms = monotonic_ms();
+            pending[pending_count].value = temperature;
+            bool last = count > 0 && n + 1 == count;
+            if (++pending_count < (size_t)batch && !last) {
+                wait_next_tick(&next, period_ns);
+                continue;
+            }
+            packet_len = frame_encode_batch(seq++, pending, pending_count, (uint8_t *)packet);
+            frame_samples = pending_count;
+            pending_count = 0;
+            if (packet_len == 0) {
+                /* Отсчёты разошлись больше чем на 65 с (процесс стоял) */
+                fprintf(stderr, "Batch of %zu samples does not fit in one frame\n", frame_samples);
+                break;
+            }
+        } else if (binary) {
+            /* Кадр: флаги, длина, номер, значение с фиксированной точкой, CRC16 */
+            packet_len = frame_encode_sample(seq++, temperature, (uint8_t *)packet);
+        } else {
+            char value_str[64];
+            double_to_string(temperature, value_str, sizeof(value_str));
+
+            char checksum[128];
+            hash_of_string(value_str, checksum, sizeof(checksum));
+
+            snprintf(packet, sizeof(packet), "%s %s\n", value_str, checksum);
+            packet_len = strlen(packet);
+        }
 
-        ssize_t written = write(fd, packet, strlen(packet));
+        ssize_t written = write(fd, packet, packet_len);
         if (written < 0) {
             perror("Write failed");
             break;
         }
 
-        printf("Sent: %.6f °C\n", temperature);
+        if (batch > 0)
+            printf("Sent: %zu samples, last %.6f °C\n", frame_samples, temperature);
+        else
+            printf("Sent: %.6f °C\n", temperature);
 
-        // Отправляем данные каждую секунду
-        sleep(1);
-
-        // Медленно меняем базовую температуру
-        base_temp += ((double)rand() / RAND_MAX) * 0.2 - 0.1;
-        if (base_temp < 15.0) base_temp = 15.0;
-        if (base_temp > 25.0) base_temp = 25.0;
+        wait_next_tick(&next, period_ns);
     }
 
     close(fd);